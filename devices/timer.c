@@ -3,6 +3,7 @@
 #include <inttypes.h>
 #include <round.h>
 #include <stdio.h>
+#include "intrinsic.h"
 #include "threads/interrupt.h"
 #include "threads/io.h"
 #include "threads/synch.h"
@@ -24,6 +25,10 @@ static int64_t ticks;
    Initialized by timer_calibrate(). */
 static unsigned loops_per_tick;
 
+/* timer interrupt handler의 비용 (rdtsc cycles).
+   TIMERSTAT으로 빌드했을 때만 잰다. */
+static struct timer_handler_stats handler_stats;
+
 static intr_handler_func timer_interrupt;
 static bool too_many_loops(unsigned loops);
 static void busy_wait(int64_t loops);
@@ -139,7 +144,34 @@ void timer_nsleep(int64_t ns) { real_time_sleep(ns, 1000 * 1000 * 1000); }
 
 /* Prints timer statistics. */
 void timer_print_stats(void) {
+  struct timer_handler_stats stats;
+
   printf("Timer: %" PRId64 " ticks\n", timer_ticks());
+
+  timer_get_handler_stats(&stats);
+  if (stats.calls > 0)
+    printf("Timer: handler %" PRIu64 " cycles/tick avg, %" PRIu64
+           " cycles max\n",
+           stats.total_cycles / stats.calls, stats.max_cycles);
+}
+
+/**
+ * @brief timer interrupt handler의 비용 통계를 stats에 복사한다.
+*/
+void timer_get_handler_stats(struct timer_handler_stats *stats) {
+  enum intr_level old_level = intr_disable();
+  *stats = handler_stats;
+  intr_set_level(old_level);
+}
+
+/**
+ * @brief timer interrupt handler의 비용 통계를 초기화한다.
+ *        (특정 구간의 handler 비용만 측정하고 싶을때 사용한다.)
+*/
+void timer_reset_handler_stats(void) {
+  enum intr_level old_level = intr_disable();
+  handler_stats = (struct timer_handler_stats){0};
+  intr_set_level(old_level);
 }
 
 /**
@@ -148,6 +180,11 @@ void timer_print_stats(void) {
  * @note Timer interrupt handler.
  */
 static void timer_interrupt(struct intr_frame *args UNUSED) {
+#ifdef TIMERSTAT
+  uint64_t start = rdtsc();
+  uint64_t cycles;
+#endif
+
   ticks++;
   thread_tick();
 
@@ -157,21 +194,20 @@ static void timer_interrupt(struct intr_frame *args UNUSED) {
 
   /* ---------- added for Project.1-3 ---------- */
 
-  if (!thread_mlfqs) return;
+  /* ---------- before incremental mlfqs ----------
+  thread_foreach(thread_update_recent_cpu, NULL);   every 1 second
+  thread_foreach(thread_set_priority_mlfqs, NULL);  every 4 ticks */
 
-  /* each ticks excute */
-  thread_increase_recent_cpu_of_running();
+  if (thread_mlfqs) thread_mlfqs_tick(ticks);
 
-  /* every 1 second */
-  if (ticks % TIMER_FREQ == 0) {
-    thread_update_load_avg();
-    thread_foreach(thread_update_recent_cpu, NULL);
-  }
+  /* ----------- added for timer wheel ----------- */
 
-  /* every 4 ticks */
-  if (ticks % 4 == 0) {
-    thread_foreach(thread_set_priority_mlfqs, NULL);
-  }
+#ifdef TIMERSTAT
+  cycles = rdtsc() - start;
+  handler_stats.calls++;
+  handler_stats.total_cycles += cycles;
+  if (cycles > handler_stats.max_cycles) handler_stats.max_cycles = cycles;
+#endif
 
   /*------------------------------------------*/
 }
@@ -136,6 +136,15 @@ file_allow_write (struct file *file) {
 	}
 }
 
+/* Returns true if FILE denies writes to its underlying inode,
+ * that is, if file_deny_write() has been called on it.  While it
+ * does, the inode's contents cannot change. */
+bool
+file_write_denied (struct file *file) {
+	ASSERT (file != NULL);
+	return file->deny_write;
+}
+
 /* Returns the size of FILE in bytes. */
 off_t
 file_length (struct file *file) {
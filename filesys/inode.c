@@ -6,6 +6,9 @@
 #include "filesys/filesys.h"
 #include "filesys/free-map.h"
 #include "threads/malloc.h"
+#include "threads/slab.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
 
 /* Identifies an inode. */
 #define INODE_MAGIC 0x494e4f44
@@ -34,6 +37,8 @@ struct inode {
 	bool removed;                       /* True if deleted, false otherwise. */
 	int deny_write_cnt;                 /* 0: writes ok, >0: deny writes. */
 	struct inode_disk data;             /* Inode content. */
+	struct rwlock rwlock;               /* Data and deny_write_cnt. */
+	struct rwlock dir_rwlock;           /* Entries, if a directory. */
 };
 
 /* Returns the disk sector that contains byte offset POS within
@@ -53,10 +58,41 @@ byte_to_sector (const struct inode *inode, off_t pos) {
  * returns the same `struct inode'. */
 static struct list open_inodes;
 
+/* Protects open_inodes and the open_cnt of every open inode.
+ * Never held across disk I/O. */
+static struct lock open_inodes_lock;
+
+/* In-memory inodes. */
+static struct kmem_cache *inode_cachep;
+
 /* Initializes the inode module. */
 void
 inode_init (void) {
 	list_init (&open_inodes);
+	lock_init (&open_inodes_lock);
+	inode_cachep = kmem_cache_create ("inode", sizeof (struct inode), 0, NULL);
+	if (inode_cachep == NULL)
+		PANIC ("inode_init: cannot create object cache");
+}
+
+/* Returns the open inode for SECTOR with its open count
+ * incremented, or a null pointer if SECTOR is not open.
+ * open_inodes_lock must be held. */
+static struct inode *
+find_open_inode (disk_sector_t sector) {
+	struct list_elem *e;
+
+	ASSERT (lock_held_by_current_thread (&open_inodes_lock));
+
+	for (e = list_begin (&open_inodes); e != list_end (&open_inodes);
+			e = list_next (e)) {
+		struct inode *inode = list_entry (e, struct inode, elem);
+		if (inode->sector == sector) {
+			inode->open_cnt++;
+			return inode;
+		}
+	}
+	return NULL;
 }
 
 /* Initializes an inode with LENGTH bytes of data and
@@ -101,39 +137,53 @@ inode_create (disk_sector_t sector, off_t length) {
  * Returns a null pointer if memory allocation fails. */
 struct inode *
 inode_open (disk_sector_t sector) {
-	struct list_elem *e;
-	struct inode *inode;
+	struct inode *inode, *other;
 
 	/* Check whether this inode is already open. */
-	for (e = list_begin (&open_inodes); e != list_end (&open_inodes);
-			e = list_next (e)) {
-		inode = list_entry (e, struct inode, elem);
-		if (inode->sector == sector) {
-			inode_reopen (inode);
-			return inode; 
-		}
-	}
+	lock_acquire (&open_inodes_lock);
+	inode = find_open_inode (sector);
+	lock_release (&open_inodes_lock);
+	if (inode != NULL)
+		return inode;
 
 	/* Allocate memory. */
-	inode = malloc (sizeof *inode);
+	inode = kmem_cache_alloc (inode_cachep);
 	if (inode == NULL)
 		return NULL;
 
-	/* Initialize. */
-	list_push_front (&open_inodes, &inode->elem);
+	/* Initialize.  The disk is read without holding
+	 * open_inodes_lock, so that opening one file does not wait
+	 * for another file's inode to come in from disk. */
 	inode->sector = sector;
 	inode->open_cnt = 1;
 	inode->deny_write_cnt = 0;
 	inode->removed = false;
+	rwlock_init (&inode->rwlock, true);
+	rwlock_init (&inode->dir_rwlock, true);
 	disk_read (filesys_disk, inode->sector, &inode->data);
+
+	/* Someone else may have opened the same inode meanwhile. */
+	lock_acquire (&open_inodes_lock);
+	other = find_open_inode (sector);
+	if (other == NULL)
+		list_push_front (&open_inodes, &inode->elem);
+	lock_release (&open_inodes_lock);
+
+	if (other != NULL) {
+		kmem_cache_free (inode_cachep, inode);
+		return other;
+	}
 	return inode;
 }
 
 /* Reopens and returns INODE. */
 struct inode *
 inode_reopen (struct inode *inode) {
-	if (inode != NULL)
+	if (inode != NULL) {
+		lock_acquire (&open_inodes_lock);
 		inode->open_cnt++;
+		lock_release (&open_inodes_lock);
+	}
 	return inode;
 }
 
@@ -148,14 +198,21 @@ inode_get_inumber (const struct inode *inode) {
  * If INODE was also a removed inode, frees its blocks. */
 void
 inode_close (struct inode *inode) {
+	bool last;
+
 	/* Ignore null pointer. */
 	if (inode == NULL)
 		return;
 
-	/* Release resources if this was the last opener. */
-	if (--inode->open_cnt == 0) {
-		/* Remove from inode list and release lock. */
+	lock_acquire (&open_inodes_lock);
+	last = --inode->open_cnt == 0;
+	if (last)
 		list_remove (&inode->elem);
+	lock_release (&open_inodes_lock);
+
+	/* Release resources if this was the last opener.  It is no
+	 * longer in the inode list, so nobody else can reach it. */
+	if (last) {
 
 		/* Deallocate blocks if removed. */
 		if (inode->removed) {
@@ -164,7 +221,7 @@ inode_close (struct inode *inode) {
 					bytes_to_sectors (inode->data.length)); 
 		}
 
-		free (inode); 
+		kmem_cache_free (inode_cachep, inode);
 	}
 }
 
@@ -178,13 +235,20 @@ inode_remove (struct inode *inode) {
 
 /* Reads SIZE bytes from INODE into BUFFER, starting at position OFFSET.
  * Returns the number of bytes actually read, which may be less
- * than SIZE if an error occurs or end of file is reached. */
+ * than SIZE if an error occurs or end of file is reached.
+ * BUFFER must be kernel memory: a page fault while the inode's
+ * rwlock is held could need the same lock again. */
 off_t
 inode_read_at (struct inode *inode, void *buffer_, off_t size, off_t offset) {
 	uint8_t *buffer = buffer_;
 	off_t bytes_read = 0;
 	uint8_t *bounce = NULL;
 
+	ASSERT (is_kernel_vaddr (buffer_));
+
+	/* Readers of the same inode, and all accesses to different
+	 * inodes, proceed in parallel. */
+	rwlock_acquire_read (&inode->rwlock);
 	while (size > 0) {
 		/* Disk sector to read, starting byte offset within sector. */
 		disk_sector_t sector_idx = byte_to_sector (inode, offset);
@@ -201,8 +265,19 @@ inode_read_at (struct inode *inode, void *buffer_, off_t size, off_t offset) {
 			break;
 
 		if (sector_ofs == 0 && chunk_size == DISK_SECTOR_SIZE) {
-			/* Read full sector directly into caller's buffer. */
-			disk_read (filesys_disk, sector_idx, buffer + bytes_read); 
+			/* Read full sectors directly into caller's buffer, as
+			   many as are adjacent on disk with one command. */
+			size_t cnt = 1;
+
+			while (cnt < DISK_MULTIPLE_MAX
+					&& size >= (off_t) (cnt + 1) * DISK_SECTOR_SIZE
+					&& inode_left >= (off_t) (cnt + 1) * DISK_SECTOR_SIZE
+					&& byte_to_sector (inode, offset + cnt * DISK_SECTOR_SIZE)
+						== sector_idx + cnt)
+				cnt++;
+			disk_read_multiple (filesys_disk, sector_idx, cnt,
+					buffer + bytes_read);
+			chunk_size = cnt * DISK_SECTOR_SIZE;
 		} else {
 			/* Read sector into bounce buffer, then partially copy
 			 * into caller's buffer. */
@@ -220,6 +295,7 @@ inode_read_at (struct inode *inode, void *buffer_, off_t size, off_t offset) {
 		offset += chunk_size;
 		bytes_read += chunk_size;
 	}
+	rwlock_release_read (&inode->rwlock);
 	free (bounce);
 
 	return bytes_read;
@@ -229,7 +305,8 @@ inode_read_at (struct inode *inode, void *buffer_, off_t size, off_t offset) {
  * Returns the number of bytes actually written, which may be
  * less than SIZE if end of file is reached or an error occurs.
  * (Normally a write at end of file would extend the inode, but
- * growth is not yet implemented.) */
+ * growth is not yet implemented.)
+ * BUFFER must be kernel memory, as for inode_read_at(). */
 off_t
 inode_write_at (struct inode *inode, const void *buffer_, off_t size,
 		off_t offset) {
@@ -237,8 +314,13 @@ inode_write_at (struct inode *inode, const void *buffer_, off_t size,
 	off_t bytes_written = 0;
 	uint8_t *bounce = NULL;
 
-	if (inode->deny_write_cnt)
+	ASSERT (is_kernel_vaddr (buffer_));
+
+	rwlock_acquire_write (&inode->rwlock);
+	if (inode->deny_write_cnt) {
+		rwlock_release_write (&inode->rwlock);
 		return 0;
+	}
 
 	while (size > 0) {
 		/* Sector to write, starting byte offset within sector. */
@@ -282,6 +364,7 @@ inode_write_at (struct inode *inode, const void *buffer_, off_t size,
 		offset += chunk_size;
 		bytes_written += chunk_size;
 	}
+	rwlock_release_write (&inode->rwlock);
 	free (bounce);
 
 	return bytes_written;
@@ -292,8 +375,10 @@ inode_write_at (struct inode *inode, const void *buffer_, off_t size,
 	void
 inode_deny_write (struct inode *inode) 
 {
+	rwlock_acquire_write (&inode->rwlock);
 	inode->deny_write_cnt++;
 	ASSERT (inode->deny_write_cnt <= inode->open_cnt);
+	rwlock_release_write (&inode->rwlock);
 }
 
 /* Re-enables writes to INODE.
@@ -301,9 +386,11 @@ inode_deny_write (struct inode *inode)
  * inode_deny_write() on the inode, before closing the inode. */
 void
 inode_allow_write (struct inode *inode) {
+	rwlock_acquire_write (&inode->rwlock);
 	ASSERT (inode->deny_write_cnt > 0);
 	ASSERT (inode->deny_write_cnt <= inode->open_cnt);
 	inode->deny_write_cnt--;
+	rwlock_release_write (&inode->rwlock);
 }
 
 /* Returns the length, in bytes, of INODE's data. */
@@ -311,3 +398,14 @@ off_t
 inode_length (const struct inode *inode) {
 	return inode->data.length;
 }
+
+/* Returns the lock that protects the entries of INODE, which
+ * must be a directory.  Kept apart from the lock on the
+ * directory's data, so that a directory operation can hold it
+ * across the inode_read_at() and inode_write_at() calls that
+ * scan and update the entries. */
+struct rwlock *
+inode_dir_lock (struct inode *inode) {
+	ASSERT (inode != NULL);
+	return &inode->dir_rwlock;
+}
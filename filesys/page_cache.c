@@ -26,17 +26,19 @@ bool
 page_cache_initializer (struct page *page, enum vm_type type, void *kva) {
 	/* Set up the handler */
 	page->operations = &page_cache_op;
-
+	return true;
 }
 
 /* Utilze the Swap in mechanism to implement readhead */
 static bool
 page_cache_readahead (struct page *page, void *kva) {
+	return false;
 }
 
 /* Utilze the Swap out mechanism to implement writeback */
 static bool
 page_cache_writeback (struct page *page) {
+	return false;
 }
 
 /* Destory the page_cache. */
@@ -2,6 +2,7 @@
 #define DEVICES_DISK_H
 
 #include <inttypes.h>
+#include <stddef.h>
 #include <stdint.h>
 
 /* Size of a disk sector in bytes. */
@@ -23,5 +24,14 @@ disk_sector_t disk_size (struct disk *);
 void disk_read (struct disk *, disk_sector_t, void *);
 void disk_write (struct disk *, disk_sector_t, const void *);
 
+/* Most sectors that one disk_*_multiple() call may transfer. */
+#define DISK_MULTIPLE_MAX 256
+
+void disk_read_multiple (struct disk *, disk_sector_t, size_t cnt, void *);
+void disk_write_multiple (struct disk *, disk_sector_t, size_t cnt,
+		const void *);
+void disk_write_gather (struct disk *, disk_sector_t,
+		const void *const bufs[], size_t buf_cnt, size_t buf_sectors);
+
 void 	register_disk_inspect_intr ();
 #endif /* devices/disk.h */
@@ -20,4 +20,16 @@ void timer_nsleep (int64_t nanoseconds);
 
 void timer_print_stats (void);
 
+/* Cost of the timer interrupt handler, measured with rdtsc.
+   Stays zero unless the kernel is built with TIMERSTAT=1. */
+struct timer_handler_stats
+  {
+    uint64_t calls;             /* # of timer interrupts handled. */
+    uint64_t total_cycles;      /* Sum of cycles spent in the handler. */
+    uint64_t max_cycles;        /* Most expensive single tick. */
+  };
+
+void timer_get_handler_stats (struct timer_handler_stats *);
+void timer_reset_handler_stats (void);
+
 #endif /* devices/timer.h */
@@ -0,0 +1,70 @@
+#ifndef __LIB_KERNEL_HEAP_H
+#define __LIB_KERNEL_HEAP_H
+
+/* Max-heap (priority queue).
+ *
+ * This is a pairing heap: pushing an element and increasing an
+ * element's key are O(1), and popping or removing an element is
+ * O(log n) amortized.  The largest element is always at the top.
+ *
+ * Like the list and hash table, this heap does not use dynamic
+ * allocation.  Each structure that can potentially be in a heap
+ * must embed a struct heap_elem member, and the heap_entry macro
+ * converts a struct heap_elem back to the structure that contains
+ * it.  Refer to lib/kernel/list.h for a detailed explanation of
+ * the technique.
+ *
+ * The key of an element that is in a heap must not change, except
+ * that it may increase if heap_increase_key() is called right
+ * after. */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Heap element. */
+struct heap_elem {
+	struct heap_elem *child;    /* First child, or NULL. */
+	struct heap_elem *next;     /* Next sibling, or NULL. */
+	struct heap_elem *prev;     /* Previous sibling, or parent if this
+	                               is the first child, or NULL at the
+	                               top. */
+};
+
+/* Converts pointer to heap element HEAP_ELEM into a pointer to
+   the structure that HEAP_ELEM is embedded inside.  Supply the
+   name of the outer structure STRUCT and the member name MEMBER
+   of the heap element. */
+#define heap_entry(HEAP_ELEM, STRUCT, MEMBER)               \
+	((STRUCT *) ((uint8_t *) &(HEAP_ELEM)->child        \
+		- offsetof (STRUCT, MEMBER.child)))
+
+/* Compares the value of two heap elements A and B, given
+   auxiliary data AUX.  Returns true if A is less than B, or false
+   if A is greater than or equal to B. */
+typedef bool heap_less_func (const struct heap_elem *a,
+                             const struct heap_elem *b,
+                             void *aux);
+
+/* Heap. */
+struct heap {
+	struct heap_elem *top;      /* Largest element, or NULL if empty. */
+	size_t size;                /* Number of elements. */
+	heap_less_func *less;       /* Comparison function. */
+	void *aux;                  /* Auxiliary data for `less'. */
+};
+
+void heap_init (struct heap *, heap_less_func *, void *aux);
+
+/* Insertion and removal. */
+void heap_push (struct heap *, struct heap_elem *);
+struct heap_elem *heap_pop (struct heap *);
+void heap_remove (struct heap *, struct heap_elem *);
+void heap_increase_key (struct heap *, struct heap_elem *);
+
+/* Heap properties. */
+struct heap_elem *heap_top (struct heap *);
+size_t heap_size (struct heap *);
+bool heap_empty (struct heap *);
+
+#endif /* lib/kernel/heap.h */
@@ -0,0 +1,74 @@
+#ifndef __LIB_KERNEL_RBTREE_H
+#define __LIB_KERNEL_RBTREE_H
+
+/* Red-black tree.
+ *
+ * A self-balancing binary search tree: insertion and removal are
+ * O(log n), and the smallest element is cached so that finding
+ * it is O(1).
+ *
+ * Like the list and hash table, this tree does not use dynamic
+ * allocation.  Each structure that can potentially be in a tree
+ * must embed a struct rb_node member, and the rb_entry macro
+ * converts a struct rb_node back to the structure that contains
+ * it.  Refer to lib/kernel/list.h for a detailed explanation of
+ * the technique.
+ *
+ * Elements are ordered by the rb_less_func given to rb_init().
+ * Elements that compare equal are kept in insertion order, so
+ * repeatedly removing the smallest element yields equal elements
+ * first-in, first-out. */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Tree node. */
+struct rb_node {
+	struct rb_node *parent;     /* Parent node, or NULL at the root. */
+	struct rb_node *left;       /* Left child, or NULL. */
+	struct rb_node *right;      /* Right child, or NULL. */
+	bool red;                   /* Red or black. */
+};
+
+/* Converts pointer to tree node RB_NODE into a pointer to the
+   structure that RB_NODE is embedded inside.  Supply the name of
+   the outer structure STRUCT and the member name MEMBER of the
+   tree node. */
+#define rb_entry(RB_NODE, STRUCT, MEMBER)                   \
+	((STRUCT *) ((uint8_t *) &(RB_NODE)->parent         \
+		- offsetof (STRUCT, MEMBER.parent)))
+
+/* Compares the value of two tree nodes A and B, given auxiliary
+   data AUX.  Returns true if A is less than B, or false if A is
+   greater than or equal to B. */
+typedef bool rb_less_func (const struct rb_node *a,
+                           const struct rb_node *b,
+                           void *aux);
+
+/* Red-black tree. */
+struct rb_tree {
+	struct rb_node *root;       /* Root node, or NULL if empty. */
+	struct rb_node *leftmost;   /* Smallest node, or NULL if empty. */
+	size_t size;                /* Number of nodes. */
+	rb_less_func *less;         /* Comparison function. */
+	void *aux;                  /* Auxiliary data for `less'. */
+};
+
+void rb_init (struct rb_tree *, rb_less_func *, void *aux);
+
+/* Insertion and removal. */
+void rb_insert (struct rb_tree *, struct rb_node *);
+void rb_remove (struct rb_tree *, struct rb_node *);
+struct rb_node *rb_pop_min (struct rb_tree *);
+
+/* Traversal. */
+struct rb_node *rb_min (struct rb_tree *);
+struct rb_node *rb_next (struct rb_node *);
+struct rb_node *rb_floor (struct rb_tree *, const struct rb_node *key);
+
+/* Tree properties. */
+size_t rb_size (struct rb_tree *);
+bool rb_empty (struct rb_tree *);
+
+#endif /* lib/kernel/rbtree.h */
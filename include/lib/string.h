@@ -25,6 +25,15 @@ size_t strlcat (char *, const char *, size_t);
 char *strtok_r (char *, const char *, char **);
 size_t strnlen (const char *, size_t);
 
+/* Byte-at-a-time reference versions of the functions above that
+   lib/string.c optimizes, for testing.  `make STRING_REF=1'
+   makes the standard names use them too. */
+void *memcpy_ref (void *, const void *, size_t);
+void *memmove_ref (void *, const void *, size_t);
+int memcmp_ref (const void *, const void *, size_t);
+void *memset_ref (void *, int, size_t);
+size_t strlen_ref (const char *);
+
 /* Try to be helpful. */
 #define strcpy dont_use_strcpy_use_strlcpy
 #define strncpy dont_use_strncpy_use_strlcpy
@@ -36,6 +36,10 @@ enum {
 
 	SYS_MOUNT,
 	SYS_UMOUNT,
+
+	/* Extra for Project 3 */
+	SYS_MSYNC,                  /* Write back a memory mapping. */
+	SYS_MADVISE,                /* Give an access hint for a mapping. */
 };
 
 #endif /* lib/syscall-nr.h */
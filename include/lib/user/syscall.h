@@ -13,6 +13,13 @@ typedef int pid_t;
 typedef int off_t;
 #define MAP_FAILED ((void *) NULL)
 
+/* Access hints for madvise(), same values as enum vm_advice. */
+#define MADV_NORMAL 0           /* No special treatment. */
+#define MADV_RANDOM 1           /* Expect random page references. */
+#define MADV_SEQUENTIAL 2       /* Expect sequential page references. */
+#define MADV_WILLNEED 3         /* Read the pages in now. */
+#define MADV_DONTNEED 4         /* Release the pages now. */
+
 /* Maximum characters in a filename written by readdir(). */
 #define READDIR_MAX_LEN 14
 
@@ -41,6 +48,8 @@ int dup2(int oldfd, int newfd);
 /* Project 3 and optionally project 4. */
 void *mmap (void *addr, size_t length, int writable, int fd, off_t offset);
 void munmap (void *addr);
+int msync (void *addr, size_t length);
+int madvise (void *addr, size_t length, int advice);
 
 /* Project 4 only. */
 bool chdir (const char *dir);
@@ -0,0 +1,40 @@
+#ifndef THREADS_HEAPPROF_H
+#define THREADS_HEAPPROF_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "threads/thread.h"
+
+/* Heap profiler and leak tracker, `make HEAPPROF=1'.
+
+   When built in and enabled with -heapprof, every live block
+   from malloc(), calloc(), realloc(), kmem_cache_alloc() and
+   palloc_get_*() is recorded with its call site, size and owning
+   thread.  Live allocations are reported by call site when a
+   thread exits and at power off; the call sites are return
+   addresses that utils/backtrace turns into function names. */
+
+/* Kind of allocation. */
+enum heapprof_kind {
+	HEAPPROF_MALLOC,            /* malloc(), calloc(), realloc(). */
+	HEAPPROF_SLAB,              /* kmem_cache_alloc(). */
+	HEAPPROF_PALLOC             /* palloc_get_page(), palloc_get_multiple(). */
+};
+
+#ifdef HEAPPROF
+/* -heapprof: record allocations? */
+extern bool heapprof;
+
+void heapprof_alloc (enum heapprof_kind, const void *ptr, size_t size,
+		const void *site);
+void heapprof_free (const void *ptr);
+void heapprof_print_leaks (tid_t);
+void heapprof_print_stats (void);
+#else
+#define heapprof_alloc(KIND, PTR, SIZE, SITE) ((void) 0)
+#define heapprof_free(PTR) ((void) 0)
+#define heapprof_print_leaks(TID) ((void) 0)
+#define heapprof_print_stats() ((void) 0)
+#endif
+
+#endif /* threads/heapprof.h */
@@ -0,0 +1,28 @@
+#ifndef THREADS_SLAB_H
+#define THREADS_SLAB_H
+
+#include <stddef.h>
+
+/* Object caches ("slab allocator").
+
+   A cache hands out objects of one fixed size, carved out of
+   whole pages ("slabs").  Unlike malloc(), which rounds every
+   request up to a power of 2, a cache packs its objects at their
+   own size, and every cache has its own lock. */
+
+struct kmem_cache;
+
+/* Constructor, called once for each object when its slab is
+   created.  Objects must be freed back in constructed state. */
+typedef void kmem_ctor_func (void *obj);
+
+void slab_init (void);
+struct kmem_cache *kmem_cache_create (const char *name, size_t size,
+		size_t align, kmem_ctor_func *);
+void *kmem_cache_alloc (struct kmem_cache *) __attribute__ ((malloc));
+void *kmem_cache_zalloc (struct kmem_cache *) __attribute__ ((malloc));
+void kmem_cache_free (struct kmem_cache *, void *);
+size_t kmem_cache_shrink (struct kmem_cache *);
+void slab_print_stats (void);
+
+#endif /* threads/slab.h */
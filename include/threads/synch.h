@@ -1,8 +1,10 @@
 #ifndef THREADS_SYNCH_H
 #define THREADS_SYNCH_H
 
+#include <heap.h>
 #include <list.h>
 #include <stdbool.h>
+#include <stdint.h>
 
 void update_priority_donation(void);
 /**
@@ -28,21 +30,82 @@ void sema_self_test(void);
  * @brief 🚻 화장실.
  * 				lock을 통해 다른 쓰레드들과의 동기화를 위한 타입 변수
  * 
+ * @param owner 잠금장치. 화장실을 잠근 사람(thread)의 주소와 LOCK_CONTENDED
+ * 									bit. CAS 한번으로 잠그고 풀 수 있다. (fast path)
  * @param holder 화장실을 잠근 사람 (현재 lock을 갖고있는 thread)
- * @param semaphore 🚽 변기. (lock에 접근이 가능한 리소스의 개수와 lock을 가지려고 
- * 									대기중인 쓰레드들의 list)
+ * @param waiters 화장실 앞에 줄 선 사람들. (lock을 가지려고 대기중인 쓰레드들의
+ * 									priority max-heap, top이 holder에게 priority를 기부한다)
+ * @param held_elem holder->held_locks를 위한 elem
+ * @param stat (LOCKSTAT) 이 lock을 초기화한 lock_init() 호출 위치의 통계
+ * @param acquired_tick (LOCKSTAT) holder가 lock을 얻은 시각
+ * 
+ * @details before O(log n) donation : binary semaphore로 구현했었다.
+ *          struct semaphore semaphore;
 */
 struct lock {
+  uintptr_t owner;            /* Holding thread | LOCK_CONTENDED. */
   struct thread *holder;      /* Thread holding lock (for debugging). */
-  struct semaphore semaphore; /* Binary semaphore controlling access. */
+  struct heap waiters;        /* Threads waiting for the lock. */
+  struct list_elem held_elem; /* List element for holder->held_locks. */
+#ifdef LOCKSTAT
+  struct lock_stat *stat; /* Statistics of the lock_init() call site. */
+  int64_t acquired_tick;  /* When the holder acquired the lock. */
+#endif
 };
 
-void lock_init(struct lock *);
+/* lock->owner의 bit 0. waiters heap이 비어있지 않아 lock_release()가
+   slow path를 타야함을 나타낸다. (struct thread는 page 단위로 정렬된다.) */
+#define LOCK_CONTENDED ((uintptr_t)1)
+
+void(lock_init)(struct lock *);
 void lock_acquire(struct lock *);
 bool lock_try_acquire(struct lock *);
 void lock_release(struct lock *);
 bool lock_held_by_current_thread(const struct lock *);
 
+/* ------------ added for lock statistics ------------ */
+
+#ifdef LOCKSTAT
+/**
+ * @brief 📊 lock contention 통계. (`make LOCKSTAT=1'로 빌드했을때만 존재)
+ * 
+ * @details lock_init()을 호출한 위치(file:line)마다 하나씩 있다. 같은
+ *          곳에서 초기화된 lock들(ex. 모든 inode의 lock)은 하나로 합쳐진다.
+ *          처음 lock_init()될때 등록되고, -lockstat을 주면 종료할때
+ *          lock_print_stats()가 출력한다.
+*/
+struct lock_stat {
+  const char *name;       /* Expression passed to lock_init(). */
+  const char *where;      /* File and line of the lock_init() call. */
+  uint64_t acquires;      /* Number of acquisitions. */
+  uint64_t contended;     /* Acquisitions that had to wait. */
+  int64_t wait_ticks;     /* Total ticks spent waiting. */
+  int64_t max_wait_ticks; /* Longest wait. */
+  int64_t hold_ticks;     /* Total ticks the lock was held. */
+  int64_t max_hold_ticks; /* Longest hold. */
+  bool registered;        /* In the list of all lock_stats? */
+  struct list_elem elem;  /* List element for the list of all lock_stats. */
+};
+
+/* -lockstat: lock 통계를 종료할때 출력할까? */
+extern bool lockstat;
+
+void lockstat_init(void);
+void lock_init_stat(struct lock *, struct lock_stat *);
+void lock_print_stats(void);
+
+#define LOCK_STAT_STR_(X) #X
+#define LOCK_STAT_STR(X) LOCK_STAT_STR_(X)
+
+/* lock_init() 호출 위치마다 static struct lock_stat을 하나씩 만든다. */
+#define lock_init(LOCK)                                                  \
+  do {                                                                   \
+    static struct lock_stat lock_stat_ = {                               \
+        .name = #LOCK, .where = __FILE__ ":" LOCK_STAT_STR(__LINE__)};   \
+    lock_init_stat(LOCK, &lock_stat_);                                   \
+  } while (0)
+#endif
+
 /* Condition variable. */
 struct condition {
   struct list waiters; /* List of waiting threads. */
@@ -53,6 +116,42 @@ void cond_wait(struct condition *, struct lock *);
 void cond_signal(struct condition *, struct lock *);
 void cond_broadcast(struct condition *, struct lock *);
 
+/* ----------- added for reader-writer lock ----------- */
+
+/**
+ * @brief 📖 reader-writer lock.
+ * 				여러 reader가 동시에 가질 수 있고, writer는 혼자서만 가질 수 있다.
+ * 
+ * @param lock 아래 field들을 보호하는 lock
+ * @param readers_ok 기다리는 reader들
+ * @param writers_ok 기다리는 writer들
+ * @param readers 현재 읽고 있는 thread의 수
+ * @param waiting_writers 기다리는 writer의 수
+ * @param writer 현재 쓰고 있는 thread (없다면 NULL)
+ * @param prefer_writer true라면 writer가 기다리는 동안 새 reader를 막는다.
+ * 
+ * @details priority-aware : 기다리는 reader와 writer 중 priority가 높은
+ *          쪽을 먼저 깨운다. (condition이 priority 순서로 깨우는 것을 이용)
+ *          prefer_writer가 false여도 자기보다 priority가 높은 writer가
+ *          기다린다면 reader는 새로 들어가지 않는다.
+*/
+struct rwlock {
+  struct lock lock;            /* Protects the fields below. */
+  struct condition readers_ok; /* Waiting readers. */
+  struct condition writers_ok; /* Waiting writers. */
+  int readers;                 /* Number of threads reading. */
+  int waiting_writers;         /* Number of threads waiting to write. */
+  struct thread *writer;       /* Thread writing, or NULL. */
+  bool prefer_writer;          /* Block new readers while a writer waits. */
+};
+
+void rwlock_init(struct rwlock *, bool prefer_writer);
+void rwlock_acquire_read(struct rwlock *);
+void rwlock_release_read(struct rwlock *);
+void rwlock_acquire_write(struct rwlock *);
+void rwlock_release_write(struct rwlock *);
+bool rwlock_held_by_current_thread(const struct rwlock *);
+
 /* Optimization barrier.
  *
  * The compiler will not reorder operations across an
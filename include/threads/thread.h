@@ -3,6 +3,7 @@
 
 #include <debug.h>
 #include <list.h>
+#include <rbtree.h>
 #include <stdint.h>
 #include "threads/interrupt.h"
 #ifdef VM
@@ -37,6 +38,9 @@ typedef int tid_t;
 #define PRI_DEFAULT 31 /* Default priority. */
 #define PRI_MAX 63     /* Highest priority. */
 
+/* 우선순위 level의 개수 (PRI_MIN ~ PRI_MAX) */
+#define PRI_CNT (PRI_MAX - PRI_MIN + 1)
+
 /* ------------ added for Project.1-1 ------------ */
 
 #define WAKEUP_TICKS_DEFAULT 0
@@ -177,8 +181,14 @@ struct thread {
 
   unsigned initial_priority; /* 상속 받기전 origin_priority */
   struct lock *wait_on_lock; /* 현재 쓰레드가 대기중인 lock */
-  struct list donations;     /* priority를 상속해준 기부자(thread) */
-  struct list_elem donation_elem; /* struct donations list를 위한 elem */
+
+  /* before O(log n) donation
+  struct list donations;          priority를 상속해준 기부자(thread)
+  struct list_elem donation_elem; struct donations list를 위한 elem */
+
+  struct list held_locks;     /* 현재 쓰레드가 가진 lock들 */
+  struct heap_elem lock_elem; /* wait_on_lock->waiters heap을 위한 elem */
+  unsigned lock_wait_seq;     /* 같은 priority의 waiter를 FIFO로 깨우기 위한 순번 */
 
   /* ----------- added for PROJECT.1-3 ----------- */
 
@@ -193,10 +203,20 @@ struct thread {
   */
   int nice;
   int recent_cpu; /* **최근** CPU사용량을 표현하는 Fixed_Point */
+  int recent_cpu_epoch; /* recent_cpu에 decay가 적용된 마지막 epoch(초) */
 
   /* 모든 쓰레드를 관리하는 active_list를 위한 elem */;
   struct list_elem active_elem;
 
+  /* ----------- added for per-CPU run queue ----------- */
+
+  struct cpu *cpu; /* 마지막으로 실행된 CPU (READY라면 대기중인 CPU) */
+
+  /* ----------- added for CFS ----------- */
+
+  int64_t vruntime;        /* nice로 가중치를 준 누적 실행 시간 */
+  struct rb_node cfs_elem; /* cpu->cfs_rq (red-black tree)를 위한 elem */
+
   /* --------------- added for PRJECT.2-2  --------------- */
 
 #ifdef USERPROG
@@ -210,6 +230,7 @@ struct thread {
   struct list fdt; /* file descriptor table */
   int next_fd; /* 테이블에 등록된 fd + 1 즉, 다음에 저장될 fd의 값을 의미한다 */
   struct file *running_file; /* 실행중인 파일 */
+  uint8_t *io_buf; /* read()/write()의 bounce page (added for per-inode rwlock) */
 
   struct semaphore exit_sema;
   struct semaphore load_sema;
@@ -235,6 +256,79 @@ struct thread {
   unsigned magic;       /* Detects stack overflow. */
 };
 
+/* ----------- added for O(1) ready queue ----------- */
+
+/**
+ * @brief 우선순위별 FIFO queue와 occupancy bitmap으로 구성된 ready queue
+ * 
+ * @property queues 우선순위(PRI_MIN ~ PRI_MAX)별 READY thread의 FIFO queue
+ * @property bitmap bit i가 1이라면 queues[i]가 비어있지 않다.
+ * @property size queue에 들어있는 thread의 총 개수
+ * 
+ * @details 삽입/삭제는 해당 우선순위의 list에 push/remove만 하면 되고,
+ *          가장 높은 우선순위는 bitmap의 최상위 bit(find-last-set)로
+ *          구하기에 모든 연산이 O(1)이다.
+*/
+struct ready_queue {
+  struct list queues[PRI_CNT];
+  uint64_t bitmap;
+  size_t size;
+};
+
+void ready_queue_init(struct ready_queue *rq);
+void ready_queue_push(struct ready_queue *rq, struct thread *t);
+void ready_queue_remove(struct ready_queue *rq, struct thread *t);
+struct thread *ready_queue_pop(struct ready_queue *rq);
+int ready_queue_max_priority(const struct ready_queue *rq);
+bool ready_queue_empty(const struct ready_queue *rq);
+size_t ready_queue_size(const struct ready_queue *rq);
+
+void thread_update_priority(struct thread *t, int priority);
+
+/* ----------- added for per-CPU run queue ----------- */
+
+#define NCPU_MAX 16 /* 지원하는 CPU의 최대 개수 */
+
+/**
+ * @brief CPU마다 하나씩 갖는 scheduler 상태
+ * 
+ * @property id CPU 번호 (cpus[] 의 index)
+ * @property curr 이 CPU에서 실행중인 thread
+ * @property idle_thread 이 CPU의 idle thread
+ * @property rq 이 CPU의 ready queue
+ * @property cfs_rq CFS일때 READY thread를 vruntime 순으로 관리하는 tree
+ * @property min_vruntime cfs_rq의 vruntime 하한, 깨어난 thread의 기준점
+ * @property cfs_weight cfs_rq에 있는 thread들의 weight 합
+ * @property thread_ticks 마지막 yield 이후 지난 timer tick
+ * 
+ * @details scheduler가 processor마다 가져야 하는 상태를 한 곳에 모은다.
+ *          READY thread는 t->cpu의 rq에 들어있다.
+ *          AP(application processor)는 깨우지 않으므로 BSP의 cpus[0] 하나만
+ *          쓰이고, rq와 cfs_rq는 interrupt를 꺼서 보호한다.
+*/
+struct cpu {
+  int id;
+  struct thread *curr;
+  struct thread *idle_thread;
+
+  struct ready_queue rq;
+  struct rb_tree cfs_rq;
+  int64_t min_vruntime;
+  int64_t cfs_weight;
+
+  unsigned thread_ticks;
+
+  /* Statistics. */
+  long long idle_ticks;   /* # of timer ticks spent idle. */
+  long long kernel_ticks; /* # of timer ticks in kernel threads. */
+  long long user_ticks;   /* # of timer ticks in user programs. */
+};
+
+extern struct cpu cpus[NCPU_MAX];
+extern int ncpu;
+
+struct cpu *this_cpu(void);
+
 /* ----------- added for Project.1 ----------- */
 
 /* Alarm Clock */
@@ -264,6 +358,9 @@ int thread_calc_decay(void);
 void thread_increase_recent_cpu_of_running(void);
 void thread_update_recent_cpu(struct thread *t, void *aux UNUSED);
 
+void thread_mlfqs_tick(int64_t ticks);
+void thread_refresh_mlfqs(struct thread *t);
+
 void thread_foreach(active_list_func exec, void *aux UNUSED);
 
 /* -------------------------------------------- */
@@ -273,6 +370,12 @@ void thread_foreach(active_list_func exec, void *aux UNUSED);
    Controlled by kernel command-line option "-o mlfqs". */
 extern bool thread_mlfqs;
 
+/* If true, use completely fair (vruntime) scheduler.
+   Controlled by kernel command-line option "-sched=cfs". */
+extern bool thread_cfs;
+
+int cfs_nice_to_weight(int nice);
+
 void thread_init(void);
 void thread_start(void);
 
@@ -15,6 +15,9 @@ struct fd_elem {
   struct file *file_ptr;
 };
 
+/* struct fd_elem을 할당하는 object cache (added for slab allocator) */
+extern struct kmem_cache *fd_elem_cachep;
+
 /* ----------------------------------------------------- */
 
 void syscall_init(void);
@@ -25,7 +28,12 @@ void validate_adress(const void *addr);
 
 /* --------------- System Calls  --------------- */
 
-struct lock filesys_lock; /* read(), write()시에 동기화 문제를 위한 lock  */
+/* ------- before per-inode locking -------
+   모든 파일 시스템 syscall을 하나의 lock으로 직렬화했었다. 이제는 inode,
+   directory, free map이 각자의 lock으로 자신을 보호하므로 서로 다른
+   파일에 대한 syscall은 동시에 진행된다. (filesys/inode.c)
+
+struct lock filesys_lock; */
 
 void do_halt(void);
 void do_exit(int status);
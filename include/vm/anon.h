@@ -2,12 +2,29 @@
 #define VM_ANON_H
 #include "vm/vm.h"
 struct page;
+struct frame;
 enum vm_type;
 
+/* ----------------- added for swap ----------------- */
+
+/* swap slot에 있지 않은 page의 swap_slot 값 */
+#define SWAP_SLOT_NONE ((size_t) -1)
+
+/* eviction 한 번에 swap disk에 모아서 쓰는 최대 page 수 */
+#define SWAP_CLUSTER 8
+
+/* -------------------------------------------------- */
+
 struct anon_page {
+	size_t swap_slot; /* added for swap : page가 저장된 slot, 없으면 SWAP_SLOT_NONE */
 };
 
 void vm_anon_init (void);
 bool anon_initializer (struct page *page, enum vm_type type, void *kva);
 
+/* added for swap */
+bool anon_swap_out_cluster (struct frame *frames[], size_t cnt);
+void anon_swap_dup (struct page *dst, struct page *src); /* added for copy-on-write */
+void swap_print_stats (void);
+
 #endif
@@ -13,11 +13,26 @@ struct file_segment_info {
   uint32_t zero_bytes;
 };
 
-struct file_page {};
+/* ------- before shared text -------
+struct file_page {}; */
+/* file에서 읽어오는 page. 내용은 FILE의 OFFSET부터 READ_BYTES만큼이고
+   나머지 ZERO_BYTES는 0이다. file은 page가 duplicate해서 가진다. */
+struct file_page {
+  struct file *file;
+  off_t offset;
+  uint32_t read_bytes;
+  uint32_t zero_bytes;
+};
+
+/* struct file_segment_info를 할당하는 object cache
+   (added for slab allocator, vm_file_init()에서 만든다) */
+extern struct kmem_cache *file_segment_cachep;
 
 void vm_file_init(void);
 bool file_backed_initializer(struct page *page, enum vm_type type, void *kva);
 void *do_mmap(void *addr, size_t length, int writable, struct file *file,
               off_t offset);
 void do_munmap(void *va);
+bool do_msync(void *addr, size_t length); /* added for mmap */
+void file_print_stats(void);              /* added for mmap */
 #endif
@@ -2,6 +2,7 @@
 #define VM_VM_H
 #include <stdbool.h>
 #include "hash.h"
+#include "rbtree.h"
 #include "threads/palloc.h"
 
 enum vm_type {
@@ -45,6 +46,27 @@ struct thread;
 /* 1MB */
 #define USER_STACK_LIMIT_SIZE (1 << 20)
 
+/* ----------------- added for fault-around ----------------- */
+
+/* fault-around로 한 번에 load하는 page 수의 기본값과 최댓값.
+   최댓값은 한 번의 disk command로 읽을 수 있는 크기(256 sectors)이다. */
+#define VM_FAULT_AROUND_DEFAULT 16
+#define VM_FAULT_AROUND_MAX 32
+
+extern unsigned vm_fault_around;
+
+/* ----------------- added for madvise ----------------- */
+
+/* madvise()로 mmap area에 주는 access hint.
+   값은 lib/user/syscall.h의 MADV_*와 같아야 한다. */
+enum vm_advice {
+  VM_ADV_NORMAL = 0,     /* vm_fault_around만큼 fault-around 한다 */
+  VM_ADV_RANDOM = 1,     /* fault-around를 하지 않는다 */
+  VM_ADV_SEQUENTIAL = 2, /* 최대로 read-ahead하고 지나간 page를 해제한다 */
+  VM_ADV_WILLNEED = 3,   /* 범위의 page를 지금 읽어온다 (기록하지 않는다) */
+  VM_ADV_DONTNEED = 4,   /* 범위의 page를 지금 해제한다 (기록하지 않는다) */
+};
+
 /* --------------------------------------------------------- */
 
 /* The representation of "page".
@@ -65,6 +87,13 @@ struct page {
 
   /* --------------------------------------------------------- */
 
+  /* ------------------ added for copy-on-write ------------------ */
+
+  struct thread *owner;          /* page를 spt에 가지고 있는 thread */
+  struct list_elem mapping_elem; /* frame->mappings의 list element */
+
+  /* ------------------------------------------------------------- */
+
   /** Per-type data are binded into the union.
 	 * Each function automatically detects the current union
    * 
@@ -81,12 +110,74 @@ struct page {
   };
 };
 
-/* The representation of "frame" */
+/* The representation of "frame".
+ * 
+ * >  copy-on-write로 여러 process의 page가 하나의 frame을 공유할 수 있다.
+ * >  공유하는 page는 모두 mappings에 들어있고, page는 그 중 하나이다. */
 struct frame {
   void *kva; /* Address in terms of kernel space */
   struct page *page;
+
+  /* ----------------- added for frame table ----------------- */
+
+  struct list_elem frame_elem; /* frame_table의 list element */
+  bool pinned;                 /* true면 eviction 대상에서 제외한다 */
+
+  /* ------- before copy-on-write -------
+  struct thread *owner; */
+  struct list mappings; /* 이 frame을 매핑한 page들 (page->mapping_elem) */
+
+  /* ----------------- added for shared text ----------------- */
+
+  /* text_cache에 들어있는 frame이면 내용을 읽어온 file의 inode와 offset.
+     아니면 inode는 NULL이다. */
+  struct inode *inode;
+  off_t offset;
+  struct hash_elem cache_elem; /* text_cache의 hash element */
+
+  /* ----------------- added for madvise ----------------- */
+
+  bool streamed; /* SEQUENTIAL area에서 읽은 frame이면 true */
+
+  /* ----------------- added for mmap ----------------- */
+
+  /* frame_lock을 놓고 file에 쓰는 중이면 true. 그동안 mappings는 바뀌지 않으며
+     page->frame으로 이 frame을 찾은 쪽은 page_frame()에서 기다린다. */
+  bool writeback;
+
+  /* --------------------------------------------------------- */
+};
+
+/* ----------------- added for slab allocator ----------------- */
+
+/* struct page, struct frame을 할당하는 object cache (vm_init()에서 만든다) */
+extern struct kmem_cache *page_cachep;
+extern struct kmem_cache *frame_cachep;
+
+/* ----------------- added for VMA ----------------- */
+
+/* 연속된 가상 주소 범위 [start, end)를 한 번에 기술하는 virtual memory area.
+ *
+ * >  load_segment()는 segment마다 area 하나만 등록하고, struct page는 그 안의
+ * >  주소에서 처음 page fault가 날 때 만든다(spt_get_page()).
+ * >  file이 NULL이거나 start + read_bytes 이후의 page는 0으로 채운다. */
+struct vm_area {
+  void *start;           /* 첫 page의 주소 */
+  void *end;             /* 마지막 page 다음 주소 */
+  bool writable;
+  enum vm_type type;     /* page가 초기화된 뒤의 type */
+  struct file *file;     /* backing file (area가 소유한다), 또는 NULL */
+  off_t offset;          /* start에 대응하는 file offset */
+  size_t read_bytes;     /* start부터 file에서 읽을 byte 수 */
+  vm_initializer *init;  /* file에서 읽는 page에 넘길 init */
+  bool mmap;             /* mmap()으로 만든 area이면 true (added for mmap) */
+  enum vm_advice advice; /* fault 처리에 쓰는 hint (added for madvise) */
+
+  struct rb_node area_elem; /* spt->areas의 element (start 순서) */
 };
 
+extern struct kmem_cache *area_cachep;
+
 /* The function table for page operations.
  * This is one way of implementing "interface" in C.
  * Put the table of "method" into the struct's member, and
@@ -120,6 +211,7 @@ struct supplemental_page_table {
   /* ----------------- added for PROJECT.3-1 ----------------- */
 
   struct hash page_table;
+  struct rb_tree areas; /* added for VMA : struct vm_area의 tree */
 
   /* --------------------------------------------------------- */
 };
@@ -132,6 +224,15 @@ void supplemental_page_table_kill(struct supplemental_page_table *spt);
 struct page *spt_find_page(struct supplemental_page_table *spt, void *va);
 bool spt_insert_page(struct supplemental_page_table *spt, struct page *page);
 void spt_remove_page(struct supplemental_page_table *spt, struct page *page);
+struct vm_area *spt_find_area(struct supplemental_page_table *spt, void *va);
+struct page *spt_get_page(struct supplemental_page_table *spt, void *va);
+struct vm_area *vm_map_area(void *start, size_t length, bool writable,
+                            enum vm_type type, struct file *file, off_t offset,
+                            size_t read_bytes, vm_initializer *init);
+void vm_unmap_area(struct vm_area *area); /* added for mmap */
+bool vm_sync_page(struct page *page);     /* added for mmap */
+bool vm_advise(void *addr, size_t length,
+               enum vm_advice advice); /* added for madvise */
 
 void vm_init(void);
 bool vm_try_handle_fault(struct intr_frame *f, void *addr, bool user,
@@ -143,6 +244,8 @@ bool vm_alloc_page_with_initializer(enum vm_type type, void *upage,
                                     bool writable, vm_initializer *init,
                                     void *aux);
 void vm_dealloc_page(struct page *page);
+void vm_free_frame(struct page *page); /* added for frame table */
+void vm_print_stats(void);                /* added for swap */
 bool vm_claim_page(void *va);
 enum vm_type page_get_type(struct page *page);
 
@@ -62,6 +62,57 @@ last_mask (const struct bitmap *b) {
 	int last_bits = b->bit_cnt % ELEM_BITS;
 	return last_bits ? ((elem_type) 1 << last_bits) - 1 : (elem_type) -1;
 }
+
+/* Word-at-a-time helpers.
+
+   The multiple-bit operations below work on whole elements: a
+   range of bits is split into a partial first element, a run of
+   whole elements and a partial last element, and each element is
+   handled with one mask instead of one bit at a time. */
+
+/* Returns a mask of the CNT bits starting at bit OFS of an
+   element.  OFS + CNT must not exceed ELEM_BITS. */
+static inline elem_type
+range_mask (size_t ofs, size_t cnt) {
+	elem_type mask = cnt < ELEM_BITS ? ((elem_type) 1 << cnt) - 1 : (elem_type) -1;
+	return mask << ofs;
+}
+
+/* Returns the number of bits set in X.  Written out because the
+   kernel is not linked with libgcc, which __builtin_popcountl()
+   may call. */
+static inline size_t
+popcount (elem_type x) {
+	x = x - ((x >> 1) & 0x5555555555555555UL);
+	x = (x & 0x3333333333333333UL) + ((x >> 2) & 0x3333333333333333UL);
+	x = (x + (x >> 4)) & 0x0f0f0f0f0f0f0f0fUL;
+	return (x * 0x0101010101010101UL) >> 56;
+}
+
+/* Returns the number of trailing zero bits in X, which must be
+   nonzero. */
+static inline size_t
+ctz (elem_type x) {
+	return __builtin_ctzl (x);
+}
+
+/* Returns element IDX of B with every bit inverted if VALUE is
+   false, so that the bits equal to VALUE are the ones set. */
+static inline elem_type
+elem_match (const struct bitmap *b, size_t idx, bool value) {
+	return value ? b->bits[idx] : ~b->bits[idx];
+}
+
+/* Returns the number of bits, at most CNT, from bit START to the
+   end of its element, and stores a mask of those bits within the
+   element into *MASK. */
+static inline size_t
+elem_span (size_t start, size_t cnt, elem_type *mask) {
+	size_t ofs = start % ELEM_BITS;
+	size_t n = ELEM_BITS - ofs < cnt ? ELEM_BITS - ofs : cnt;
+	*mask = range_mask (ofs, n);
+	return n;
+}
 
 /* Creation and destruction. */
 
@@ -194,33 +245,49 @@ bitmap_set_all (struct bitmap *b, bool value) {
 	bitmap_set_multiple (b, 0, bitmap_size (b), value);
 }
 
-/* Sets the CNT bits starting at START in B to VALUE. */
+/* Sets the CNT bits starting at START in B to VALUE.
+   Whole elements are stored at once; the partial elements at
+   either end are updated atomically, like bitmap_mark(). */
 void
 bitmap_set_multiple (struct bitmap *b, size_t start, size_t cnt, bool value) {
-	size_t i;
-
 	ASSERT (b != NULL);
 	ASSERT (start <= b->bit_cnt);
 	ASSERT (start + cnt <= b->bit_cnt);
 
-	for (i = 0; i < cnt; i++)
-		bitmap_set (b, start + i, value);
+	while (cnt > 0) {
+		elem_type mask;
+		size_t n = elem_span (start, cnt, &mask);
+		size_t idx = elem_idx (start);
+
+		if (mask == (elem_type) -1)
+			b->bits[idx] = value ? (elem_type) -1 : 0;
+		else if (value)
+			asm ("lock orq %1, %0" : "=m" (b->bits[idx]) : "r" (mask) : "cc");
+		else
+			asm ("lock andq %1, %0" : "=m" (b->bits[idx]) : "r" (~mask) : "cc");
+		start += n;
+		cnt -= n;
+	}
 }
 
 /* Returns the number of bits in B between START and START + CNT,
    exclusive, that are set to VALUE. */
 size_t
 bitmap_count (const struct bitmap *b, size_t start, size_t cnt, bool value) {
-	size_t i, value_cnt;
+	size_t value_cnt = 0;
 
 	ASSERT (b != NULL);
 	ASSERT (start <= b->bit_cnt);
 	ASSERT (start + cnt <= b->bit_cnt);
 
-	value_cnt = 0;
-	for (i = 0; i < cnt; i++)
-		if (bitmap_test (b, start + i) == value)
-			value_cnt++;
+	while (cnt > 0) {
+		elem_type mask;
+		size_t n = elem_span (start, cnt, &mask);
+
+		value_cnt += popcount (elem_match (b, elem_idx (start), value) & mask);
+		start += n;
+		cnt -= n;
+	}
 	return value_cnt;
 }
 
@@ -228,15 +295,19 @@ bitmap_count (const struct bitmap *b, size_t start, size_t cnt, bool value) {
    exclusive, are set to VALUE, and false otherwise. */
 bool
 bitmap_contains (const struct bitmap *b, size_t start, size_t cnt, bool value) {
-	size_t i;
-
 	ASSERT (b != NULL);
 	ASSERT (start <= b->bit_cnt);
 	ASSERT (start + cnt <= b->bit_cnt);
 
-	for (i = 0; i < cnt; i++)
-		if (bitmap_test (b, start + i) == value)
+	while (cnt > 0) {
+		elem_type mask;
+		size_t n = elem_span (start, cnt, &mask);
+
+		if (elem_match (b, elem_idx (start), value) & mask)
 			return true;
+		start += n;
+		cnt -= n;
+	}
 	return false;
 }
 
@@ -269,15 +340,62 @@ bitmap_all (const struct bitmap *b, size_t start, size_t cnt) {
    If there is no such group, returns BITMAP_ERROR. */
 size_t
 bitmap_scan (const struct bitmap *b, size_t start, size_t cnt, bool value) {
+	size_t run_start = start, run_len = 0;
+	size_t idx;
+
 	ASSERT (b != NULL);
 	ASSERT (start <= b->bit_cnt);
 
-	if (cnt <= b->bit_cnt) {
-		size_t last = b->bit_cnt - cnt;
-		size_t i;
-		for (i = start; i <= last; i++)
-			if (!bitmap_contains (b, i, cnt, !value))
-				return i;
+	if (cnt > b->bit_cnt)
+		return BITMAP_ERROR;
+	if (cnt == 0)
+		return start;
+
+	/* Track the run of bits equal to VALUE that reaches the end of
+	   the current element, across elements.  Bits before START
+	   and past the end of B count as not equal to VALUE. */
+	for (idx = elem_idx (start); idx < elem_cnt (b->bit_cnt); idx++) {
+		elem_type w = elem_match (b, idx, value);
+		size_t pos = 0;
+
+		if (idx == elem_idx (start))
+			w &= (elem_type) -1 << (start % ELEM_BITS);
+		if (idx == elem_cnt (b->bit_cnt) - 1)
+			w &= last_mask (b);
+
+		/* Whole element matches: extend the run. */
+		if (w == (elem_type) -1) {
+			if (run_len == 0)
+				run_start = idx * ELEM_BITS;
+			run_len += ELEM_BITS;
+			if (run_len >= cnt)
+				return run_start;
+			continue;
+		}
+
+		/* Otherwise walk the runs of set bits in W. */
+		while (pos < ELEM_BITS) {
+			elem_type rest = w >> pos;
+			size_t ones;
+
+			if (rest == 0) {
+				run_len = 0;
+				break;
+			}
+			if ((rest & 1) == 0) {
+				run_len = 0;
+				pos += ctz (rest);
+				rest = w >> pos;
+			}
+
+			ones = ~rest != 0 ? ctz (~rest) : ELEM_BITS - pos;
+			if (run_len == 0)
+				run_start = idx * ELEM_BITS + pos;
+			run_len += ones;
+			if (run_len >= cnt)
+				return run_start;
+			pos += ones;
+		}
 	}
 	return BITMAP_ERROR;
 }
@@ -0,0 +1,192 @@
+#include "heap.h"
+#include "../debug.h"
+
+/* Pairing heap, see Fredman et al., "The pairing heap: A new form
+   of self-adjusting heap" (1986).
+
+   The heap is a tree in which every element is greater than or
+   equal to its children.  The children of an element form a
+   doubly linked list through `next' and `prev', and the first
+   child's `prev' points back to the parent, so that any element
+   can be cut out of the tree in O(1).
+
+   All the work is done by two operations: meld() links two trees
+   by making the smaller root the first child of the larger, and
+   merge_pairs() combines a list of siblings into one tree when
+   their parent is removed. */
+
+/* Links the trees rooted at A and B, either of which may be null,
+   and returns the root of the result.  A and B must not have
+   siblings. */
+static struct heap_elem *
+meld (struct heap *heap, struct heap_elem *a, struct heap_elem *b) {
+	if (a == NULL)
+		return b;
+	if (b == NULL)
+		return a;
+
+	/* Make A the larger root.  On a tie A, the older tree, stays
+	   on top. */
+	if (heap->less (a, b, heap->aux)) {
+		struct heap_elem *tmp = a;
+		a = b;
+		b = tmp;
+	}
+
+	b->prev = a;
+	b->next = a->child;
+	if (a->child != NULL)
+		a->child->prev = b;
+	a->child = b;
+	return a;
+}
+
+/* Combines the list of siblings starting at FIRST into a single
+   tree and returns its root, or a null pointer if FIRST is null.
+
+   Two passes: siblings are melded in pairs from left to right,
+   then the pairs are melded from right to left.  This is what
+   gives the heap its O(log n) amortized bound. */
+static struct heap_elem *
+merge_pairs (struct heap *heap, struct heap_elem *first) {
+	struct heap_elem *pairs = NULL;
+	struct heap_elem *result = NULL;
+
+	while (first != NULL) {
+		struct heap_elem *a = first;
+		struct heap_elem *b = a->next;
+		struct heap_elem *pair;
+
+		first = b != NULL ? b->next : NULL;
+		a->next = a->prev = NULL;
+		if (b != NULL)
+			b->next = b->prev = NULL;
+
+		/* Push the pair onto a stack, linked through `next'. */
+		pair = meld (heap, a, b);
+		pair->next = pairs;
+		pairs = pair;
+	}
+
+	while (pairs != NULL) {
+		struct heap_elem *pair = pairs;
+
+		pairs = pair->next;
+		pair->next = NULL;
+		result = meld (heap, result, pair);
+	}
+	return result;
+}
+
+/* Cuts the subtree rooted at ELEM, which must not be the top, out
+   of the tree. */
+static void
+cut (struct heap_elem *elem) {
+	if (elem->prev->child == elem)
+		elem->prev->child = elem->next;
+	else
+		elem->prev->next = elem->next;
+	if (elem->next != NULL)
+		elem->next->prev = elem->prev;
+	elem->next = elem->prev = NULL;
+}
+
+/* Initializes HEAP as an empty heap ordered by LESS, given
+   auxiliary data AUX. */
+void
+heap_init (struct heap *heap, heap_less_func *less, void *aux) {
+	ASSERT (heap != NULL);
+	ASSERT (less != NULL);
+
+	heap->top = NULL;
+	heap->size = 0;
+	heap->less = less;
+	heap->aux = aux;
+}
+
+/* Inserts ELEM into HEAP.  O(1). */
+void
+heap_push (struct heap *heap, struct heap_elem *elem) {
+	ASSERT (heap != NULL);
+	ASSERT (elem != NULL);
+
+	elem->child = elem->next = elem->prev = NULL;
+	heap->top = meld (heap, heap->top, elem);
+	heap->size++;
+}
+
+/* Removes the largest element from HEAP and returns it.  Returns
+   a null pointer if HEAP is empty.  O(log n) amortized. */
+struct heap_elem *
+heap_pop (struct heap *heap) {
+	struct heap_elem *top;
+
+	ASSERT (heap != NULL);
+
+	top = heap->top;
+	if (top != NULL) {
+		heap->top = merge_pairs (heap, top->child);
+		top->child = NULL;
+		heap->size--;
+	}
+	return top;
+}
+
+/* Removes ELEM, which must be in HEAP, from HEAP.  O(log n)
+   amortized. */
+void
+heap_remove (struct heap *heap, struct heap_elem *elem) {
+	struct heap_elem *children;
+
+	ASSERT (heap != NULL);
+	ASSERT (elem != NULL);
+
+	if (elem == heap->top) {
+		heap_pop (heap);
+		return;
+	}
+
+	cut (elem);
+	children = merge_pairs (heap, elem->child);
+	elem->child = NULL;
+	heap->top = meld (heap, heap->top, children);
+	heap->size--;
+}
+
+/* Restores the heap order after the key of ELEM, which must be in
+   HEAP, has increased.  O(1). */
+void
+heap_increase_key (struct heap *heap, struct heap_elem *elem) {
+	ASSERT (heap != NULL);
+	ASSERT (elem != NULL);
+
+	if (elem == heap->top)
+		return;
+
+	/* ELEM is still greater than or equal to its children, so its
+	   subtree can be moved as a whole. */
+	cut (elem);
+	heap->top = meld (heap, heap->top, elem);
+}
+
+/* Returns the largest element in HEAP, or a null pointer if HEAP
+   is empty.  O(1). */
+struct heap_elem *
+heap_top (struct heap *heap) {
+	ASSERT (heap != NULL);
+	return heap->top;
+}
+
+/* Returns the number of elements in HEAP. */
+size_t
+heap_size (struct heap *heap) {
+	ASSERT (heap != NULL);
+	return heap->size;
+}
+
+/* Returns true if HEAP is empty, false otherwise. */
+bool
+heap_empty (struct heap *heap) {
+	ASSERT (heap != NULL);
+	return heap->top == NULL;
+}
@@ -0,0 +1,363 @@
+#include "rbtree.h"
+#include "../debug.h"
+
+/* Red-black tree, following the algorithms in Cormen et al.,
+   "Introduction to Algorithms", chapter 13.  Leaves are
+   represented by null pointers and are black, so a few helpers
+   below treat a null node as black.
+
+   The tree maintains these invariants:
+
+   1. Every node is red or black, and the root is black.
+   2. A red node has no red child.
+   3. Every path from a node down to a leaf contains the same
+   number of black nodes.
+
+   Together they bound the height of the tree to 2 lg (n + 1). */
+
+/* Returns true if NODE is red.  Null leaves are black. */
+static inline bool
+is_red (const struct rb_node *node) {
+	return node != NULL && node->red;
+}
+
+/* Returns true if NODE is black.  Null leaves are black. */
+static inline bool
+is_black (const struct rb_node *node) {
+	return !is_red (node);
+}
+
+/* Returns the smallest node in the subtree rooted at NODE. */
+static struct rb_node *
+subtree_min (struct rb_node *node) {
+	while (node->left != NULL)
+		node = node->left;
+	return node;
+}
+
+/* Makes NEW take OLD's place as a child of PARENT, or as the root
+   of TREE if PARENT is null.  Does not update NEW->parent. */
+static void
+replace_child (struct rb_tree *tree, struct rb_node *parent,
+		struct rb_node *old, struct rb_node *new) {
+	if (parent == NULL)
+		tree->root = new;
+	else if (parent->left == old)
+		parent->left = new;
+	else
+		parent->right = new;
+}
+
+/* Rotates the subtree rooted at X to the left:
+
+        X                 Y
+       / \               / \
+      a   Y     ==>     X   c
+         / \           / \
+        b   c         a   b
+   */
+static void
+rotate_left (struct rb_tree *tree, struct rb_node *x) {
+	struct rb_node *y = x->right;
+
+	x->right = y->left;
+	if (y->left != NULL)
+		y->left->parent = x;
+	y->parent = x->parent;
+	replace_child (tree, x->parent, x, y);
+	y->left = x;
+	x->parent = y;
+}
+
+/* Rotates the subtree rooted at X to the right.  The mirror image
+   of rotate_left(). */
+static void
+rotate_right (struct rb_tree *tree, struct rb_node *x) {
+	struct rb_node *y = x->left;
+
+	x->left = y->right;
+	if (y->right != NULL)
+		y->right->parent = x;
+	y->parent = x->parent;
+	replace_child (tree, x->parent, x, y);
+	y->right = x;
+	x->parent = y;
+}
+
+/* Initializes TREE as an empty tree ordered by LESS, given
+   auxiliary data AUX. */
+void
+rb_init (struct rb_tree *tree, rb_less_func *less, void *aux) {
+	ASSERT (tree != NULL);
+	ASSERT (less != NULL);
+
+	tree->root = NULL;
+	tree->leftmost = NULL;
+	tree->size = 0;
+	tree->less = less;
+	tree->aux = aux;
+}
+
+/* Inserts NODE into TREE.  NODE is placed after any nodes that
+   compare equal to it.  O(log n). */
+void
+rb_insert (struct rb_tree *tree, struct rb_node *node) {
+	struct rb_node *parent = NULL;
+	struct rb_node **link = &tree->root;
+	bool leftmost = true;
+
+	ASSERT (tree != NULL);
+	ASSERT (node != NULL);
+
+	/* Ordinary binary search tree insertion. */
+	while (*link != NULL) {
+		parent = *link;
+		if (tree->less (node, parent, tree->aux))
+			link = &parent->left;
+		else {
+			link = &parent->right;
+			leftmost = false;
+		}
+	}
+
+	node->parent = parent;
+	node->left = node->right = NULL;
+	node->red = true;
+	*link = node;
+
+	if (leftmost)
+		tree->leftmost = node;
+	tree->size++;
+
+	/* Restore invariant 2, which is the only one that inserting a
+	   red node can break. */
+	while (is_red (node->parent)) {
+		struct rb_node *p = node->parent;
+		struct rb_node *g = p->parent;
+
+		if (p == g->left) {
+			struct rb_node *uncle = g->right;
+
+			if (is_red (uncle)) {
+				p->red = uncle->red = false;
+				g->red = true;
+				node = g;
+			} else {
+				if (node == p->right) {
+					node = p;
+					rotate_left (tree, node);
+					p = node->parent;
+				}
+				p->red = false;
+				g->red = true;
+				rotate_right (tree, g);
+			}
+		} else {
+			struct rb_node *uncle = g->left;
+
+			if (is_red (uncle)) {
+				p->red = uncle->red = false;
+				g->red = true;
+				node = g;
+			} else {
+				if (node == p->left) {
+					node = p;
+					rotate_right (tree, node);
+					p = node->parent;
+				}
+				p->red = false;
+				g->red = true;
+				rotate_left (tree, g);
+			}
+		}
+	}
+	tree->root->red = false;
+}
+
+/* Restores invariant 3 after a black node was removed from the
+   position now held by X (which may be a null leaf) below
+   PARENT. */
+static void
+remove_fixup (struct rb_tree *tree, struct rb_node *x,
+		struct rb_node *parent) {
+	while (x != tree->root && is_black (x)) {
+		if (x == parent->left) {
+			struct rb_node *w = parent->right;
+
+			if (is_red (w)) {
+				w->red = false;
+				parent->red = true;
+				rotate_left (tree, parent);
+				w = parent->right;
+			}
+			if (is_black (w->left) && is_black (w->right)) {
+				w->red = true;
+				x = parent;
+				parent = x->parent;
+			} else {
+				if (is_black (w->right)) {
+					w->left->red = false;
+					w->red = true;
+					rotate_right (tree, w);
+					w = parent->right;
+				}
+				w->red = parent->red;
+				parent->red = false;
+				w->right->red = false;
+				rotate_left (tree, parent);
+				x = tree->root;
+			}
+		} else {
+			struct rb_node *w = parent->left;
+
+			if (is_red (w)) {
+				w->red = false;
+				parent->red = true;
+				rotate_right (tree, parent);
+				w = parent->left;
+			}
+			if (is_black (w->left) && is_black (w->right)) {
+				w->red = true;
+				x = parent;
+				parent = x->parent;
+			} else {
+				if (is_black (w->left)) {
+					w->right->red = false;
+					w->red = true;
+					rotate_left (tree, w);
+					w = parent->left;
+				}
+				w->red = parent->red;
+				parent->red = false;
+				w->left->red = false;
+				rotate_right (tree, parent);
+				x = tree->root;
+			}
+		}
+	}
+	if (x != NULL)
+		x->red = false;
+}
+
+/* Removes NODE, which must be in TREE, from TREE.  O(log n). */
+void
+rb_remove (struct rb_tree *tree, struct rb_node *node) {
+	struct rb_node *child, *parent;
+	bool removed_red;
+
+	ASSERT (tree != NULL);
+	ASSERT (node != NULL);
+	ASSERT (tree->size > 0);
+
+	if (tree->leftmost == node)
+		tree->leftmost = rb_next (node);
+
+	if (node->left == NULL || node->right == NULL) {
+		/* NODE has at most one child, which takes its place. */
+		child = node->left != NULL ? node->left : node->right;
+		parent = node->parent;
+		removed_red = node->red;
+
+		if (child != NULL)
+			child->parent = parent;
+		replace_child (tree, parent, node, child);
+	} else {
+		/* NODE's successor, which has no left child, takes its
+		   place, and the successor's right child takes the
+		   successor's place. */
+		struct rb_node *succ = subtree_min (node->right);
+
+		removed_red = succ->red;
+		child = succ->right;
+
+		if (succ->parent == node)
+			parent = succ;
+		else {
+			parent = succ->parent;
+			parent->left = child;
+			if (child != NULL)
+				child->parent = parent;
+			succ->right = node->right;
+			succ->right->parent = succ;
+		}
+
+		succ->left = node->left;
+		succ->left->parent = succ;
+		succ->parent = node->parent;
+		replace_child (tree, node->parent, node, succ);
+		succ->red = node->red;
+	}
+
+	tree->size--;
+
+	if (!removed_red)
+		remove_fixup (tree, child, parent);
+}
+
+/* Removes the smallest node from TREE and returns it.  Returns a
+   null pointer if TREE is empty. */
+struct rb_node *
+rb_pop_min (struct rb_tree *tree) {
+	struct rb_node *min = tree->leftmost;
+
+	if (min != NULL)
+		rb_remove (tree, min);
+	return min;
+}
+
+/* Returns the smallest node in TREE, or a null pointer if TREE is
+   empty.  O(1). */
+struct rb_node *
+rb_min (struct rb_tree *tree) {
+	ASSERT (tree != NULL);
+	return tree->leftmost;
+}
+
+/* Returns the node that follows NODE in TREE's order, or a null
+   pointer if NODE is the largest node. */
+struct rb_node *
+rb_next (struct rb_node *node) {
+	ASSERT (node != NULL);
+
+	if (node->right != NULL)
+		return subtree_min (node->right);
+
+	while (node->parent != NULL && node == node->parent->right)
+		node = node->parent;
+	return node->parent;
+}
+
+/* Returns the largest node in TREE that is not greater than KEY,
+   or a null pointer if every node is greater than KEY.  KEY is
+   compared with TREE's less function and need not be in TREE.
+   O(log n). */
+struct rb_node *
+rb_floor (struct rb_tree *tree, const struct rb_node *key) {
+	struct rb_node *node, *floor = NULL;
+
+	ASSERT (tree != NULL);
+	ASSERT (key != NULL);
+
+	for (node = tree->root; node != NULL; )
+		if (tree->less (key, node, tree->aux))
+			node = node->left;
+		else {
+			floor = node;
+			node = node->right;
+		}
+	return floor;
+}
+
+/* Returns the number of nodes in TREE. */
+size_t
+rb_size (struct rb_tree *tree) {
+	ASSERT (tree != NULL);
+	return tree->size;
+}
+
+/* Returns true if TREE is empty, false otherwise. */
+bool
+rb_empty (struct rb_tree *tree) {
+	ASSERT (tree != NULL);
+	return tree->root == NULL;
+}
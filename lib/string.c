@@ -1,5 +1,50 @@
 #include <string.h>
 #include <debug.h>
+#include <stdint.h>
+
+/* memcpy(), memmove() and memset() move most of their bytes with
+   the x86-64 string instructions, eight bytes at a time, after
+   moving a few single bytes to align the destination.  memcmp()
+   and strlen() read a word at a time.  Blocks shorter than
+   SMALL_SIZE are handled a byte at a time, which is cheaper than
+   starting up a string instruction.
+
+   The original byte-at-a-time versions are kept below as
+   memcpy_ref() and friends. */
+
+/* Blocks shorter than this are handled a byte at a time. */
+#define SMALL_SIZE 16
+
+/* A 64-bit word that may be unaligned and may alias anything. */
+typedef uint64_t __attribute__ ((may_alias, aligned (1))) word_t;
+
+/* Word with every byte set to 0x01, and to 0x80. */
+#define ONES  0x0101010101010101ULL
+#define HIGHS 0x8080808080808080ULL
+
+/* Returns the number of bytes from P to the next multiple of 8,
+   but not more than SIZE. */
+static inline size_t
+align_head (const void *p, size_t size) {
+	size_t head = -(uintptr_t) p & 7;
+	return head < size ? head : size;
+}
+
+/* Copies CNT bytes from *SRC to *DST with `rep movsb', advancing
+   both pointers. */
+static inline void
+copy_bytes (unsigned char **dst, const unsigned char **src, size_t cnt) {
+	asm volatile ("rep movsb"
+			: "+D" (*dst), "+S" (*src), "+c" (cnt) : : "memory");
+}
+
+/* Copies CNT 8-byte words from *SRC to *DST with `rep movsq',
+   advancing both pointers. */
+static inline void
+copy_words (unsigned char **dst, const unsigned char **src, size_t cnt) {
+	asm volatile ("rep movsq"
+			: "+D" (*dst), "+S" (*src), "+c" (cnt) : : "memory");
+}
 
 /* Copies SIZE bytes from SRC to DST, which must not overlap.
    Returns DST. */
@@ -7,12 +52,26 @@ void *
 memcpy (void *dst_, const void *src_, size_t size) {
 	unsigned char *dst = dst_;
 	const unsigned char *src = src_;
+	size_t head;
 
 	ASSERT (dst != NULL || size == 0);
 	ASSERT (src != NULL || size == 0);
 
-	while (size-- > 0)
-		*dst++ = *src++;
+#ifdef STRING_REF
+	return memcpy_ref (dst_, src_, size);
+#endif
+
+	if (size < SMALL_SIZE) {
+		while (size-- > 0)
+			*dst++ = *src++;
+		return dst_;
+	}
+
+	head = align_head (dst, size);
+	copy_bytes (&dst, &src, head);
+	size -= head;
+	copy_words (&dst, &src, size / 8);
+	copy_bytes (&dst, &src, size % 8);
 
 	return dst_;
 }
@@ -23,21 +82,47 @@ void *
 memmove (void *dst_, const void *src_, size_t size) {
 	unsigned char *dst = dst_;
 	const unsigned char *src = src_;
+	size_t tail, words;
 
 	ASSERT (dst != NULL || size == 0);
 	ASSERT (src != NULL || size == 0);
 
-	if (dst < src) {
-		while (size-- > 0)
-			*dst++ = *src++;
-	} else {
-		dst += size;
-		src += size;
-		while (size-- > 0)
-			*--dst = *--src;
+#ifdef STRING_REF
+	return memmove_ref (dst_, src_, size);
+#endif
+
+	/* Copying forward is safe unless DST starts inside SRC. */
+	if (dst <= src || dst >= src + size)
+		return memcpy (dst_, src_, size);
+
+	/* Copy backward: single bytes until the end of DST is
+	   aligned, then words with the direction flag set, then the
+	   remaining bytes. */
+	dst += size;
+	src += size;
+	tail = (uintptr_t) dst & 7;
+	if (tail > size)
+		tail = size;
+	size -= tail;
+	while (tail-- > 0)
+		*--dst = *--src;
+
+	words = size / 8;
+	if (words > 0) {
+		unsigned char *d = dst - 8;
+		const unsigned char *s = src - 8;
+
+		asm volatile ("std; rep movsq; cld"
+				: "+D" (d), "+S" (s), "+c" (words) : : "memory", "cc");
+		dst -= size / 8 * 8;
+		src -= size / 8 * 8;
 	}
 
-	return dst;
+	size %= 8;
+	while (size-- > 0)
+		*--dst = *--src;
+
+	return dst_;
 }
 
 /* Find the first differing byte in the two blocks of SIZE bytes
@@ -52,6 +137,15 @@ memcmp (const void *a_, const void *b_, size_t size) {
 	ASSERT (a != NULL || size == 0);
 	ASSERT (b != NULL || size == 0);
 
+#ifdef STRING_REF
+	return memcmp_ref (a_, b_, size);
+#endif
+
+	/* Skip over equal words, then find the differing byte. */
+	for (; size >= 8; a += 8, b += 8, size -= 8)
+		if (*(const word_t *) a != *(const word_t *) b)
+			break;
+
 	for (; size-- > 0; a++, b++)
 		if (*a != *b)
 			return *a > *b ? +1 : -1;
@@ -257,9 +351,31 @@ strtok_r (char *s, const char *delimiters, char **save_ptr) {
 void *
 memset (void *dst_, int value, size_t size) {
 	unsigned char *dst = dst_;
+	size_t head, words;
 
 	ASSERT (dst != NULL || size == 0);
 
+#ifdef STRING_REF
+	return memset_ref (dst_, value, size);
+#endif
+
+	if (size < SMALL_SIZE) {
+		while (size-- > 0)
+			*dst++ = value;
+		return dst_;
+	}
+
+	head = align_head (dst, size);
+	size -= head;
+	while (head-- > 0)
+		*dst++ = value;
+
+	words = size / 8;
+	asm volatile ("rep stosq"
+			: "+D" (dst), "+c" (words)
+			: "a" ((uint64_t) (unsigned char) value * ONES) : "memory");
+
+	size %= 8;
 	while (size-- > 0)
 		*dst++ = value;
 
@@ -273,8 +389,25 @@ strlen (const char *string) {
 
 	ASSERT (string);
 
-	for (p = string; *p != '\0'; p++)
-		continue;
+#ifdef STRING_REF
+	return strlen_ref (string);
+#endif
+
+	/* Check single bytes up to a word boundary, then whole
+	   words.  An aligned word never crosses into the next page,
+	   so reading past the terminator is harmless. */
+	for (p = string; (uintptr_t) p & 7; p++)
+		if (*p == '\0')
+			return p - string;
+
+	for (;; p += 8) {
+		uint64_t w = *(const word_t *) p;
+		if ((w - ONES) & ~w & HIGHS)
+			break;
+	}
+
+	while (*p != '\0')
+		p++;
 	return p - string;
 }
 
@@ -345,3 +478,81 @@ strlcat (char *dst, const char *src, size_t size) {
 	return src_len + dst_len;
 }
 
+/* Reference versions. */
+
+/* Byte-at-a-time memcpy(). */
+void *
+memcpy_ref (void *dst_, const void *src_, size_t size) {
+	unsigned char *dst = dst_;
+	const unsigned char *src = src_;
+
+	ASSERT (dst != NULL || size == 0);
+	ASSERT (src != NULL || size == 0);
+
+	while (size-- > 0)
+		*dst++ = *src++;
+
+	return dst_;
+}
+
+/* Byte-at-a-time memmove(). */
+void *
+memmove_ref (void *dst_, const void *src_, size_t size) {
+	unsigned char *dst = dst_;
+	const unsigned char *src = src_;
+
+	ASSERT (dst != NULL || size == 0);
+	ASSERT (src != NULL || size == 0);
+
+	if (dst < src) {
+		while (size-- > 0)
+			*dst++ = *src++;
+	} else {
+		dst += size;
+		src += size;
+		while (size-- > 0)
+			*--dst = *--src;
+	}
+
+	return dst_;
+}
+
+/* Byte-at-a-time memcmp(). */
+int
+memcmp_ref (const void *a_, const void *b_, size_t size) {
+	const unsigned char *a = a_;
+	const unsigned char *b = b_;
+
+	ASSERT (a != NULL || size == 0);
+	ASSERT (b != NULL || size == 0);
+
+	for (; size-- > 0; a++, b++)
+		if (*a != *b)
+			return *a > *b ? +1 : -1;
+	return 0;
+}
+
+/* Byte-at-a-time memset(). */
+void *
+memset_ref (void *dst_, int value, size_t size) {
+	unsigned char *dst = dst_;
+
+	ASSERT (dst != NULL || size == 0);
+
+	while (size-- > 0)
+		*dst++ = value;
+
+	return dst_;
+}
+
+/* Byte-at-a-time strlen(). */
+size_t
+strlen_ref (const char *string) {
+	const char *p;
+
+	ASSERT (string);
+
+	for (p = string; *p != '\0'; p++)
+		continue;
+	return p - string;
+}
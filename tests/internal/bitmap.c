@@ -0,0 +1,137 @@
+/* Test program for lib/kernel/bitmap.c.
+
+   Checks bitmap_set_multiple(), bitmap_count(),
+   bitmap_contains() and bitmap_scan(), which work on whole
+   elements at a time, against a plain array of bools, over
+   bitmaps of many sizes and fill ratios.
+
+   This is not a test we will run on your submitted projects.
+   It is here for completeness.
+*/
+
+#undef NDEBUG
+#include <bitmap.h>
+#include <debug.h>
+#include <random.h>
+#include <stdio.h>
+#include "threads/test.h"
+
+/* Maximum number of bits in a bitmap that we will test. */
+#define MAX_SIZE 300
+
+/* Reference copy of the bitmap under test. */
+static bool ref[MAX_SIZE];
+
+static size_t ref_count (size_t start, size_t cnt, bool value);
+static size_t ref_scan (size_t size, size_t start, size_t cnt, bool value);
+static void verify_bitmap (const struct bitmap *, size_t size);
+
+/* Test the bitmap implementation. */
+void
+test (void) 
+{
+  size_t size;
+
+  printf ("testing various size bitmaps:");
+  for (size = 0; size < MAX_SIZE; size += size < 140 ? 1 : 7) 
+    {
+      int fill;
+
+      printf (" %zu", size);
+      for (fill = 0; fill <= 100; fill += 10) 
+        {
+          struct bitmap *b = bitmap_create (size);
+          size_t i;
+          int op;
+
+          ASSERT (b != NULL);
+
+          /* Fill about FILL percent of the bits at random. */
+          for (i = 0; i < size; i++) 
+            {
+              ref[i] = random_ulong () % 100 < (unsigned) fill;
+              bitmap_set (b, i, ref[i]);
+            }
+          verify_bitmap (b, size);
+
+          /* Apply random operations and compare each result. */
+          for (op = 0; op < 100; op++) 
+            {
+              size_t start = random_ulong () % (size + 1);
+              size_t cnt = random_ulong () % (size - start + 1);
+              bool value = random_ulong () % 2;
+
+              switch (random_ulong () % 4) 
+                {
+                case 0:
+                  bitmap_set_multiple (b, start, cnt, value);
+                  for (i = 0; i < cnt; i++)
+                    ref[start + i] = value;
+                  verify_bitmap (b, size);
+                  break;
+
+                case 1:
+                  ASSERT (bitmap_count (b, start, cnt, value)
+                          == ref_count (start, cnt, value));
+                  break;
+
+                case 2:
+                  ASSERT (bitmap_contains (b, start, cnt, value)
+                          == (ref_count (start, cnt, value) != 0));
+                  break;
+
+                case 3:
+                  /* Mostly short runs, sometimes runs longer than
+                     the rest of the bitmap. */
+                  cnt = random_ulong () % (random_ulong () % 4
+                                           ? size / 4 + 2 : size + 3);
+                  ASSERT (bitmap_scan (b, start, cnt, value)
+                          == ref_scan (size, start, cnt, value));
+                  break;
+                }
+            }
+
+          bitmap_destroy (b);
+        }
+    }
+  printf (" done\n");
+}
+
+/* Returns the number of bits in REF between START and START +
+   CNT, exclusive, that are set to VALUE. */
+static size_t
+ref_count (size_t start, size_t cnt, bool value) 
+{
+  size_t i, value_cnt = 0;
+
+  for (i = 0; i < cnt; i++)
+    if (ref[start + i] == value)
+      value_cnt++;
+  return value_cnt;
+}
+
+/* Bit-at-a-time bitmap_scan() over the first SIZE bits of REF. */
+static size_t
+ref_scan (size_t size, size_t start, size_t cnt, bool value) 
+{
+  size_t i;
+
+  if (cnt > size)
+    return BITMAP_ERROR;
+  for (i = start; i + cnt <= size; i++)
+    if (ref_count (i, cnt, value) == cnt)
+      return i;
+  return BITMAP_ERROR;
+}
+
+/* Verifies that B holds the same SIZE bits as REF. */
+static void
+verify_bitmap (const struct bitmap *b, size_t size) 
+{
+  size_t i;
+
+  ASSERT (bitmap_size (b) == size);
+  for (i = 0; i < size; i++)
+    ASSERT (bitmap_test (b, i) == ref[i]);
+  ASSERT (bitmap_count (b, 0, size, true) == ref_count (0, size, true));
+}
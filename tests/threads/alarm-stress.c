@@ -0,0 +1,96 @@
+/* Puts 5,000 threads to sleep with random deadlines and checks
+   that every one of them wakes up on time, then reports the cost
+   of the timer interrupt handler while they were sleeping.
+
+   Each sleeper needs its own page, so run this with enough
+   memory, e.g. `pintos -m 64 -- -q run alarm-stress'.  The
+   handler cost is only measured in a kernel built with
+   `make TIMERSTAT=1'. */
+
+#include <stdio.h>
+#include <random.h>
+#include "devices/timer.h"
+#include "tests/threads/tests.h"
+#include "threads/interrupt.h"
+#include "threads/malloc.h"
+#include "threads/thread.h"
+
+#define SLEEPER_CNT 5000
+#define MAX_DEADLINE 1000
+
+struct sleeper {
+  int64_t deadline; /* # of ticks to sleep. */
+  int64_t start;    /* Tick when the sleeper went to sleep. */
+  int64_t woke;     /* Tick when the sleeper woke up. */
+};
+
+static int woke_cnt;
+
+static thread_func sleeper_func;
+
+void test_alarm_stress(void) {
+  struct timer_handler_stats stats;
+  struct sleeper *sleepers;
+  int64_t max_late = 0;
+  int i;
+
+  ASSERT(!thread_mlfqs);
+
+  sleepers = malloc(sizeof *sleepers * SLEEPER_CNT);
+  if (sleepers == NULL) fail("out of memory");
+
+  msg("creating %d sleepers with deadlines up to %d ticks.", SLEEPER_CNT,
+      MAX_DEADLINE);
+
+  random_init(0);
+  woke_cnt = 0;
+  for (i = 0; i < SLEEPER_CNT; i++) {
+    char name[16];
+
+    sleepers[i].deadline = 1 + random_ulong() % MAX_DEADLINE;
+    snprintf(name, sizeof name, "sleeper %d", i);
+    if (thread_create(name, PRI_DEFAULT, sleeper_func, &sleepers[i]) ==
+        TID_ERROR)
+      fail("thread_create failed for sleeper %d", i);
+  }
+
+  /* Measure only while the sleepers are asleep. */
+  timer_reset_handler_stats();
+  timer_sleep(MAX_DEADLINE + 2 * TIMER_FREQ);
+  timer_get_handler_stats(&stats);
+
+  if (woke_cnt != SLEEPER_CNT)
+    fail("only %d of %d sleepers woke up", woke_cnt, SLEEPER_CNT);
+
+  for (i = 0; i < SLEEPER_CNT; i++) {
+    struct sleeper *s = &sleepers[i];
+    int64_t late = s->woke - (s->start + s->deadline);
+
+    if (late < 0)
+      fail("sleeper %d woke up %lld ticks early", i, -late);
+    if (late > max_late) max_late = late;
+  }
+
+  msg("all sleepers woke up, at most %lld ticks late.", max_late);
+  if (stats.calls > 0)
+    msg("timer interrupt: %llu ticks, %llu cycles/tick avg, %llu cycles max.",
+        stats.calls, stats.total_cycles / stats.calls, stats.max_cycles);
+  else
+    msg("timer interrupt cost not measured (build with TIMERSTAT=1).");
+
+  free(sleepers);
+  pass();
+}
+
+static void sleeper_func(void *s_) {
+  struct sleeper *s = s_;
+  enum intr_level old_level;
+
+  s->start = timer_ticks();
+  timer_sleep(s->deadline);
+  s->woke = timer_ticks();
+
+  old_level = intr_disable();
+  woke_cnt++;
+  intr_set_level(old_level);
+}
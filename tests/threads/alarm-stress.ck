@@ -0,0 +1,28 @@
+# -*- perl -*-
+
+# The test itself fails if a sleeper never wakes up or wakes up
+# early.  The timing wheel must also not wake them late.  Waking
+# 5,000 threads takes a few time slices of scheduling, but a sleeper
+# that cascades down from the outer wheel into the wrong slot would
+# be late by up to a full turn of the 256-slot inner wheel.
+
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+common_checks ("run", @output);
+
+@output = get_core_output ("run", @output);
+fail "missing PASS in output"
+  unless grep ($_ eq '(alarm-stress) PASS', @output);
+
+my ($late) = map (/^\(alarm-stress\) all sleepers woke up, at most (\d+) ticks late/,
+		  @output);
+fail "missing lateness in output\n" if !defined $late;
+fail "a sleeper woke up $late ticks late, expected at most 20\n"
+  if $late > 20;
+
+pass;
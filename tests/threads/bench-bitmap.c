@@ -0,0 +1,83 @@
+/* Measures bitmap_scan() and bitmap_count() on a 256K-bit bitmap
+   at several fill ratios.
+
+   For every ratio the bitmap is filled at random so that about
+   that share of its bits are true, then ROUNDS scans from bit 0
+   for runs of 1, 8 and 64 false bits are timed, along with a
+   bitmap_count() of the whole bitmap.  The same scans are also
+   timed bit at a time, the way bitmap_scan() used to work, and
+   their results are checked against each other. */
+
+#include <bitmap.h>
+#include <random.h>
+#include <stdio.h>
+#include "intrinsic.h"
+#include "tests/threads/tests.h"
+#include "threads/malloc.h"
+
+#define BIT_CNT (256 * 1024)
+#define ROUNDS 10
+
+static const int fills[] = {0, 50, 90, 99, 100};
+static const size_t runs[] = {1, 8, 64};
+
+/* Bit-at-a-time scan for CNT consecutive VALUE bits in B,
+   starting at bit 0. */
+static size_t ref_scan(const struct bitmap *b, size_t cnt, bool value) {
+  size_t size = bitmap_size(b);
+  size_t i, run = 0;
+
+  for (i = 0; i < size; i++) {
+    run = bitmap_test(b, i) == value ? run + 1 : 0;
+    if (run == cnt) return i + 1 - cnt;
+  }
+  return BITMAP_ERROR;
+}
+
+void test_bench_bitmap(void) {
+  struct bitmap *b = bitmap_create(BIT_CNT);
+  size_t f, r;
+
+  if (b == NULL) fail("bitmap_create(%d) failed", BIT_CNT);
+  random_init(0);
+
+  for (f = 0; f < sizeof fills / sizeof *fills; f++) {
+    uint64_t start, cycles;
+    size_t i, count = 0;
+    int round;
+
+    for (i = 0; i < BIT_CNT; i++)
+      bitmap_set(b, i, random_ulong() % 100 < (unsigned long)fills[f]);
+
+    start = rdtsc();
+    for (round = 0; round < ROUNDS; round++)
+      count = bitmap_count(b, 0, BIT_CNT, true);
+    cycles = (rdtsc() - start) / ROUNDS;
+    msg("fill %d%%: %zu bits set, bitmap_count %llu cycles.", fills[f], count,
+        cycles);
+
+    for (r = 0; r < sizeof runs / sizeof *runs; r++) {
+      uint64_t ref_cycles;
+      size_t idx = 0, ref_idx = 0;
+
+      start = rdtsc();
+      for (round = 0; round < ROUNDS; round++)
+        idx = bitmap_scan(b, 0, runs[r], false);
+      cycles = (rdtsc() - start) / ROUNDS;
+
+      start = rdtsc();
+      for (round = 0; round < ROUNDS; round++)
+        ref_idx = ref_scan(b, runs[r], false);
+      ref_cycles = (rdtsc() - start) / ROUNDS;
+
+      if (idx != ref_idx)
+        fail("scan for %zu false bits at fill %d%%: got %zu, expected %zu",
+             runs[r], fills[f], idx, ref_idx);
+      msg("fill %d%%, run of %zu: bitmap_scan %llu cycles, bit at a time "
+          "%llu cycles.", fills[f], runs[r], cycles, ref_cycles);
+    }
+  }
+
+  bitmap_destroy(b);
+  pass();
+}
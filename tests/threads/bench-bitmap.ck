@@ -0,0 +1,34 @@
+# -*- perl -*-
+
+# bitmap_scan() skips whole words of true bits, so for runs of 8
+# and 64 false bits it must beat the bit-at-a-time scan at every
+# fill ratio.  Runs of a single bit are not compared: at low fill
+# ratios both scans stop within the first few bits.
+
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+common_checks ("run", @output);
+
+@output = get_core_output ("run", @output);
+fail "missing PASS in output"
+  unless grep ($_ eq '(bench-bitmap) PASS', @output);
+
+my ($cnt) = 0;
+foreach (@output) {
+    my ($fill, $run, $scan, $ref)
+      = /^\(bench-bitmap\) fill (\d+)%, run of (\d+): bitmap_scan (\d+) cycles, bit at a time (\d+) cycles\./
+	or next;
+    $cnt++;
+    next if $run < 8;
+    fail "scan for $run false bits at fill $fill% took $scan cycles, "
+      . "not less than the $ref of a bit-at-a-time scan\n"
+      if $scan >= $ref;
+}
+fail "expected 15 scan timings in output, found $cnt\n" if $cnt != 15;
+
+pass;
@@ -0,0 +1,114 @@
+/* Measures lock_release() on a contended lock with 8 and with 200
+   waiters donating their priority to the holder.
+
+   The main thread holds a lock while threads with random
+   priorities block on it.  Then the lock is handed from waiter to
+   waiter, highest priority first; every holder times its own
+   lock_release(), which pops the next waiter from the lock's
+   priority heap, so the average should barely grow with the number
+   of waiters.  Also checks that the waiters got the lock in order
+   of priority. */
+
+#include <stdio.h>
+#include <random.h>
+#include "devices/timer.h"
+#include "intrinsic.h"
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/interrupt.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+#define WAITER_CNT 200
+
+static struct lock lock;
+static struct semaphore done;
+
+static int order[WAITER_CNT]; /* Priorities in order of acquisition. */
+static int acquired;
+static uint64_t release_cycles, release_max;
+
+static thread_func waiter_func;
+static void bench(int cnt);
+
+/* Releases the lock and times it.  Runs at PRI_MAX meanwhile, so
+   that the waiter that gets the lock does not preempt us before
+   we stop the clock, then drops back to BASE_PRIORITY. */
+static void timed_release(int base_priority) {
+  uint64_t start, cycles;
+
+  thread_set_priority(PRI_MAX);
+
+  start = rdtsc();
+  lock_release(&lock);
+  cycles = rdtsc() - start;
+
+  release_cycles += cycles;
+  if (cycles > release_max) release_max = cycles;
+
+  thread_set_priority(base_priority);
+}
+
+void test_bench_lock_donate(void) {
+  ASSERT(!thread_mlfqs);
+
+  lock_init(&lock);
+  random_init(0);
+
+  bench(8);
+  bench(WAITER_CNT);
+
+  thread_set_priority(PRI_DEFAULT);
+  pass();
+}
+
+/* Hands the lock through CNT waiters and reports the average cost
+   of lock_release(). */
+static void bench(int cnt) {
+  int i;
+
+  sema_init(&done, 0);
+  lock_acquire(&lock);
+  thread_set_priority(PRI_MIN);
+
+  msg("creating %d waiters with random priorities.", cnt);
+  for (i = 0; i < cnt; i++) {
+    int priority = PRI_MIN + 1 + random_ulong() % (PRI_MAX - PRI_MIN);
+    void *aux = (void *)(intptr_t)priority;
+    char name[16];
+
+    snprintf(name, sizeof name, "waiter %d", i);
+    if (thread_create(name, priority, waiter_func, aux) == TID_ERROR)
+      fail("thread_create failed for waiter %d", i);
+  }
+
+  /* Let the waiters that did not preempt us block on the lock. */
+  timer_sleep(10);
+
+  msg("main holds the lock at donated priority %d.", thread_get_priority());
+
+  acquired = 0;
+  release_cycles = release_max = 0;
+  timed_release(PRI_MIN);
+
+  for (i = 0; i < cnt; i++) sema_down(&done);
+
+  for (i = 1; i < cnt; i++)
+    if (order[i] > order[i - 1])
+      fail("waiter %d (priority %d) got the lock after priority %d", i,
+           order[i], order[i - 1]);
+
+  msg("all %d waiters got the lock in priority order.", cnt);
+  msg("lock_release with %d waiters: %llu cycles avg, %llu cycles max "
+      "over %d releases.",
+      cnt, release_cycles / (cnt + 1), release_max, cnt + 1);
+}
+
+static void waiter_func(void *priority_) {
+  int priority = (intptr_t)priority_;
+
+  lock_acquire(&lock);
+  order[acquired++] = thread_get_priority();
+  timed_release(priority);
+  sema_up(&done);
+}
@@ -0,0 +1,33 @@
+# -*- perl -*-
+
+# The test itself fails if the waiters do not get the lock in order
+# of priority.  Popping the next waiter from the lock's heap is
+# O(log n), so lock_release() with 200 waiters may cost at most
+# twice as much as with 8; scanning a list of waiters and donors
+# would cost many times more.
+
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+common_checks ("run", @output);
+
+@output = get_core_output ("run", @output);
+fail "missing PASS in output"
+  unless grep ($_ eq '(bench-lock-donate) PASS', @output);
+
+my (%avg);
+foreach (@output) {
+    $avg{$1} = $2
+      if /^\(bench-lock-donate\) lock_release with (\d+) waiters: (\d+) cycles avg/;
+}
+fail "missing lock_release cost in output\n"
+  if !defined $avg{8} || !defined $avg{200};
+fail "lock_release took $avg{200} cycles with 200 waiters, "
+  . "more than twice the $avg{8} with 8\n"
+  if $avg{200} > 2 * $avg{8};
+
+pass;
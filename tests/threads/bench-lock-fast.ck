@@ -0,0 +1,28 @@
+# -*- perl -*-
+
+# An uncontended lock_acquire() and lock_release() pair must be
+# cheaper than the sema_down() and sema_up() pair that every lock
+# used to take.
+
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+common_checks ("run", @output);
+
+@output = get_core_output ("run", @output);
+fail "missing PASS in output"
+  unless grep ($_ eq '(bench-lock-fast) PASS', @output);
+
+my ($lock) = map (/^\(bench-lock-fast\) lock_acquire\/lock_release: (\d+) cycles per pair/,
+		  @output);
+my ($sema) = map (/^\(bench-lock-fast\) sema_down\/sema_up: (\d+) cycles per pair/,
+		  @output);
+fail "missing timings in output\n" if !defined $lock || !defined $sema;
+fail "lock pair took $lock cycles, not less than the $sema of a sema pair\n"
+  if $lock >= $sema;
+
+pass;
@@ -0,0 +1,73 @@
+/* Measures malloc() and free() throughput with 1 and 8 threads.
+
+   Every thread repeatedly allocates a batch of BATCH blocks of
+   random sizes between 16 bytes and 1 kB, writes to each one,
+   then frees them all, which is the allocate-and-free loop that
+   used to make malloc() give arenas back to the page allocator
+   and get them again.  Reports the total malloc() plus free()
+   calls per second of all the threads together. */
+
+#include <random.h>
+#include <stdio.h>
+#include <string.h>
+#include "devices/timer.h"
+#include "tests/threads/tests.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+#define BATCH 32
+#define ROUNDS 4000
+
+static struct semaphore done;
+
+static thread_func stress_func;
+
+/* Runs THREAD_CNT threads of the stress loop and reports their
+   combined throughput. */
+static void run_stress(int thread_cnt) {
+  int64_t start, ticks;
+  long long ops = 2LL * BATCH * ROUNDS * thread_cnt;
+  int i;
+
+  sema_init(&done, 0);
+  start = timer_ticks();
+  for (i = 0; i < thread_cnt; i++) {
+    char name[24];
+
+    snprintf(name, sizeof name, "stress %d", i);
+    if (thread_create(name, PRI_DEFAULT, stress_func, NULL) == TID_ERROR)
+      fail("thread_create failed for stress thread %d", i);
+  }
+  for (i = 0; i < thread_cnt; i++) sema_down(&done);
+  ticks = timer_elapsed(start);
+  if (ticks == 0) ticks = 1;
+
+  msg("%d thread(s): %lld ops in %lld ticks, %lld ops/sec.", thread_cnt, ops,
+      (long long)ticks, ops * TIMER_FREQ / ticks);
+}
+
+void test_bench_malloc(void) {
+  random_init(0);
+
+  run_stress(1);
+  run_stress(8);
+  pass();
+}
+
+static void stress_func(void *aux UNUSED) {
+  void *blocks[BATCH];
+  int round, i;
+
+  for (round = 0; round < ROUNDS; round++) {
+    for (i = 0; i < BATCH; i++) {
+      size_t size = 16 + random_ulong() % 1009;
+
+      blocks[i] = malloc(size);
+      if (blocks[i] == NULL) fail("malloc(%zu) failed", size);
+      memset(blocks[i], i, 16);
+    }
+    for (i = 0; i < BATCH; i++) free(blocks[i]);
+  }
+  sema_up(&done);
+}
@@ -0,0 +1,33 @@
+# -*- perl -*-
+
+# With one CPU, 8 threads cannot do more malloc() and free() calls
+# per second than 1 thread, but they must not do far fewer either:
+# freed blocks stay in the per-CPU magazine and empty arenas are
+# kept, so switching between threads does not send pages back and
+# forth to the page allocator.
+
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+common_checks ("run", @output);
+
+@output = get_core_output ("run", @output);
+fail "missing PASS in output"
+  unless grep ($_ eq '(bench-malloc) PASS', @output);
+
+my (%rate);
+foreach (@output) {
+    $rate{$1} = $2
+      if /^\(bench-malloc\) (\d+) thread\(s\): \d+ ops in \d+ ticks, (\d+) ops\/sec\./;
+}
+fail "missing throughput in output\n"
+  if !defined $rate{1} || !defined $rate{8};
+fail "8 threads did $rate{8} ops/sec, less than half the $rate{1} "
+  . "of 1 thread\n"
+  if $rate{8} < $rate{1} / 2;
+
+pass;
@@ -0,0 +1,90 @@
+/* Measures palloc_get_multiple() and palloc_free_multiple()
+   throughput for single-page and multi-page requests.
+
+   First the kernel pool is fragmented by allocating FRAG_CNT
+   pages and freeing every other one.  Then ROUNDS allocations of
+   1, 8 and 33 pages are timed, each freed right away.
+
+   For comparison, the same requests are timed on the first-fit
+   bitmap scan that palloc used before the buddy allocator: a
+   bitmap of REF_PAGES pages whose first FRAG_CNT pages are
+   fragmented the same way, searched from index 0 with
+   bitmap_scan_and_flip() on every request. */
+
+#include <bitmap.h>
+#include <stdio.h>
+#include "intrinsic.h"
+#include "tests/threads/tests.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+
+#define FRAG_CNT 1024
+#define REF_PAGES 8192
+#define ROUNDS 1000
+
+static void *frag[FRAG_CNT];
+
+static const size_t sizes[] = {1, 8, 33};
+
+/* Returns the average cycles to allocate and free PAGE_CNT pages
+   with palloc. */
+static uint64_t time_palloc(size_t page_cnt) {
+  uint64_t start = rdtsc();
+  int i;
+
+  for (i = 0; i < ROUNDS; i++) {
+    void *pages = palloc_get_multiple(0, page_cnt);
+    if (pages == NULL) fail("palloc_get_multiple(%zu) failed", page_cnt);
+    palloc_free_multiple(pages, page_cnt);
+  }
+  return (rdtsc() - start) / ROUNDS;
+}
+
+/* Returns the average cycles to allocate and free PAGE_CNT pages
+   with a first-fit scan of REF, under LOCK like palloc did. */
+static uint64_t time_bitmap(struct bitmap *ref, struct lock *lock,
+                            size_t page_cnt) {
+  uint64_t start = rdtsc();
+  int i;
+
+  for (i = 0; i < ROUNDS; i++) {
+    size_t idx;
+
+    lock_acquire(lock);
+    idx = bitmap_scan_and_flip(ref, 0, page_cnt, false);
+    lock_release(lock);
+    if (idx == BITMAP_ERROR) fail("bitmap_scan_and_flip(%zu) failed", page_cnt);
+    bitmap_set_multiple(ref, idx, page_cnt, false);
+  }
+  return (rdtsc() - start) / ROUNDS;
+}
+
+void test_bench_palloc(void) {
+  struct bitmap *ref;
+  struct lock lock;
+  size_t i;
+
+  lock_init(&lock);
+  ref = bitmap_create(REF_PAGES);
+  if (ref == NULL) fail("bitmap_create failed");
+
+  /* Fragment both. */
+  for (i = 0; i < FRAG_CNT; i++) {
+    frag[i] = palloc_get_page(0);
+    if (frag[i] == NULL) fail("out of pages after %zu", i);
+    bitmap_mark(ref, i);
+  }
+  for (i = 0; i < FRAG_CNT; i += 2) {
+    palloc_free_page(frag[i]);
+    frag[i] = NULL;
+    bitmap_reset(ref, i);
+  }
+
+  for (i = 0; i < sizeof sizes / sizeof *sizes; i++)
+    msg("%zu page(s): buddy %llu cycles, bitmap first-fit %llu cycles.",
+        sizes[i], time_palloc(sizes[i]), time_bitmap(ref, &lock, sizes[i]));
+
+  for (i = 1; i < FRAG_CNT; i += 2) palloc_free_page(frag[i]);
+  bitmap_destroy(ref);
+  pass();
+}
@@ -0,0 +1,36 @@
+# -*- perl -*-
+
+# With the kernel pool fragmented, the buddy allocator finds a
+# multi-page block in its free list for that order, while the old
+# first-fit scan has to walk past every hole that is too small.
+# Single pages are not compared: the first hole fits them, so the
+# first-fit scan stops at once there too.
+
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+common_checks ("run", @output);
+
+@output = get_core_output ("run", @output);
+fail "missing PASS in output"
+  unless grep ($_ eq '(bench-palloc) PASS', @output);
+
+my (%buddy, %ref);
+foreach (@output) {
+    ($buddy{$1}, $ref{$1}) = ($2, $3)
+      if /^\(bench-palloc\) (\d+) page\(s\): buddy (\d+) cycles, bitmap first-fit (\d+) cycles\./;
+}
+foreach my $cnt (1, 8, 33) {
+    fail "missing timings for $cnt page(s)\n" if !defined $buddy{$cnt};
+}
+foreach my $cnt (8, 33) {
+    fail "allocating $cnt pages took $buddy{$cnt} cycles, "
+      . "not less than the $ref{$cnt} of a first-fit scan\n"
+      if $buddy{$cnt} >= $ref{$cnt};
+}
+
+pass;
@@ -0,0 +1,40 @@
+# -*- perl -*-
+
+# The multi-level ready queue must be O(1): its cost per operation
+# may not grow much from 10 to 1,000 runnable threads, and with
+# 1,000 threads it must beat the sorted list, whose inserts walk the
+# list.
+
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+common_checks ("run", @output);
+
+@output = get_core_output ("run", @output);
+fail "missing PASS in output"
+  unless grep ($_ eq '(bench-ready-queue) PASS', @output);
+
+my (%rq, %list);
+foreach (@output) {
+    $rq{$1} = $2 + $3
+      if /^\(bench-ready-queue\)\s+(\d+) threads: ready_queue enqueue (\d+), dequeue (\d+)/;
+    $list{$1} = $2 + $3
+      if /^\(bench-ready-queue\)\s+(\d+) threads: sorted list enqueue (\d+), dequeue (\d+)/;
+}
+foreach my $cnt (10, 1000) {
+    fail "missing timings for $cnt threads\n"
+      if !defined $rq{$cnt} || !defined $list{$cnt};
+}
+
+fail "ready_queue takes $rq{1000} cycles per enqueue+dequeue with 1000 "
+  . "threads, not less than the sorted list's $list{1000}\n"
+  if $rq{1000} >= $list{1000};
+fail "ready_queue takes $rq{1000} cycles per enqueue+dequeue with 1000 "
+  . "threads, more than 4 times the $rq{10} with 10 threads\n"
+  if $rq{1000} > 4 * $rq{10};
+
+pass;
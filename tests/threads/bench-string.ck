@@ -0,0 +1,34 @@
+# -*- perl -*-
+
+# memcpy() and memset() move a word at a time once the destination
+# is aligned, so from 256 bytes up they must beat the byte-at-a-time
+# reference versions, aligned or not.  Smaller blocks are not
+# compared: there the call and the alignment dominate.
+
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+common_checks ("run", @output);
+
+@output = get_core_output ("run", @output);
+fail "missing PASS in output"
+  unless grep ($_ eq '(bench-string) PASS', @output);
+
+my ($cnt) = 0;
+foreach (@output) {
+    my ($func, $size, $ofs, $cycles, $ref)
+      = /^\(bench-string\) (\w+) (\d+) bytes \+(\d+): (\d+) cycles \(\d+ B\/100c\), ref (\d+) cycles/
+	or next;
+    $cnt++;
+    next if $size < 256;
+    fail "$func of $size bytes at +$ofs took $cycles cycles, "
+      . "not less than the reference's $ref\n"
+      if $cycles >= $ref;
+}
+fail "expected 28 timings in output, found $cnt\n" if $cnt != 28;
+
+pass;
@@ -0,0 +1,128 @@
+/* Measures fairness and wake-up latency of the completely fair
+   scheduler (-sched=cfs).
+
+   Four CPU-bound threads with nice 0, 0, 5 and 10 spin for 20
+   seconds while counting the ticks they receive.  Each should get
+   a share of the CPU proportional to its weight, see
+   cfs_nice_to_weight().  Meanwhile an "interactive" thread
+   repeatedly sleeps for 5 ticks and records how many ticks late
+   it actually runs after its deadline. */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include "devices/timer.h"
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+#define LOAD_CNT 4
+#define SLEEP_TICKS 5
+
+static const int load_nice[LOAD_CNT] = {0, 0, 5, 10};
+
+struct load_info {
+  int64_t start_time;
+  int tick_count;
+  int nice;
+};
+
+struct interactive_info {
+  int64_t start_time;
+  int wakeups;
+  int64_t total_latency;
+  int64_t max_latency;
+};
+
+static thread_func load_thread;
+static thread_func interactive_thread;
+
+/* Threads sleep until this many ticks after start_time, then
+   measure for spin_time ticks. */
+static const int64_t sleep_time = 2 * TIMER_FREQ;
+static const int64_t spin_time = 20 * TIMER_FREQ;
+
+void test_bench_cfs_fair(void) {
+  struct load_info info[LOAD_CNT];
+  struct interactive_info ia;
+  int64_t start_time;
+  int total_ticks = 0, total_weight = 0;
+  int i;
+
+  ASSERT(thread_cfs);
+
+  thread_set_nice(-20);
+
+  start_time = timer_ticks();
+  msg("Starting %d load threads and 1 interactive thread...", LOAD_CNT);
+  for (i = 0; i < LOAD_CNT; i++) {
+    char name[16];
+
+    info[i].start_time = start_time;
+    info[i].tick_count = 0;
+    info[i].nice = load_nice[i];
+
+    snprintf(name, sizeof name, "load %d", i);
+    thread_create(name, PRI_DEFAULT, load_thread, &info[i]);
+  }
+
+  ia.start_time = start_time;
+  ia.wakeups = 0;
+  ia.total_latency = 0;
+  ia.max_latency = 0;
+  thread_create("interactive", PRI_DEFAULT, interactive_thread, &ia);
+
+  msg("Sleeping %d seconds to let threads run, please wait...",
+      (int)((sleep_time + spin_time) / TIMER_FREQ + 2));
+  timer_sleep(sleep_time + spin_time + 2 * TIMER_FREQ);
+
+  for (i = 0; i < LOAD_CNT; i++) {
+    total_ticks += info[i].tick_count;
+    total_weight += cfs_nice_to_weight(info[i].nice);
+  }
+
+  for (i = 0; i < LOAD_CNT; i++) {
+    int weight = cfs_nice_to_weight(info[i].nice);
+
+    msg("Thread %d (nice %d) received %d ticks, fair share %d ticks.", i,
+        info[i].nice, info[i].tick_count, total_ticks * weight / total_weight);
+  }
+
+  if (ia.wakeups == 0) fail("interactive thread never woke up");
+  msg("Interactive thread woke up %d times, %" PRId64 ".%02" PRId64
+      " ticks late on average, at most %" PRId64 " ticks late.",
+      ia.wakeups, ia.total_latency / ia.wakeups,
+      ia.total_latency * 100 / ia.wakeups % 100, ia.max_latency);
+
+  pass();
+}
+
+static void load_thread(void *info_) {
+  struct load_info *info = info_;
+  int64_t last_time = 0;
+
+  thread_set_nice(info->nice);
+  timer_sleep(sleep_time - timer_elapsed(info->start_time));
+  while (timer_elapsed(info->start_time) < sleep_time + spin_time) {
+    int64_t cur_time = timer_ticks();
+    if (cur_time != last_time) info->tick_count++;
+    last_time = cur_time;
+  }
+}
+
+static void interactive_thread(void *ia_) {
+  struct interactive_info *ia = ia_;
+
+  timer_sleep(sleep_time - timer_elapsed(ia->start_time));
+  while (timer_elapsed(ia->start_time) < sleep_time + spin_time) {
+    int64_t deadline = timer_ticks() + SLEEP_TICKS;
+    int64_t latency;
+
+    timer_sleep(SLEEP_TICKS);
+    latency = timer_ticks() - deadline;
+
+    ia->wakeups++;
+    ia->total_latency += latency;
+    if (latency > ia->max_latency) ia->max_latency = latency;
+  }
+}
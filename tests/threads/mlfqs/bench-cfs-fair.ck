@@ -0,0 +1,40 @@
+# -*- perl -*-
+
+# Under -sched=cfs every load thread must get within 20% of its
+# weighted fair share of the CPU, and the interactive thread, which
+# sleeps most of the time, must run soon after it wakes up.
+
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+common_checks ("run", @output);
+
+@output = get_core_output ("run", @output);
+fail "missing PASS in output"
+  unless grep ($_ eq '(bench-cfs-fair) PASS', @output);
+
+my ($load_cnt) = 0;
+foreach (@output) {
+    my ($i, $nice, $ticks, $share)
+      = /^\(bench-cfs-fair\) Thread (\d+) \(nice (\d+)\) received (\d+) ticks, fair share (\d+) ticks\./
+	or next;
+    $load_cnt++;
+    fail "thread $i (nice $nice) received $ticks ticks, "
+      . "more than 20% off its fair share of $share\n"
+      if abs ($ticks - $share) > $share / 5;
+}
+fail "expected 4 load threads in output, found $load_cnt\n"
+  if $load_cnt != 4;
+
+my ($avg) = map (/^\(bench-cfs-fair\) Interactive thread woke up \d+ times, (\d+\.\d+) ticks late on average/,
+		 @output);
+fail "missing interactive thread latency in output\n" if !defined $avg;
+fail "interactive thread ran $avg ticks late on average, "
+  . "expected at most 1\n"
+  if $avg > 1;
+
+pass;
@@ -0,0 +1,87 @@
+/* Measures the cost of the timer interrupt handler under the
+   4.4BSD scheduler while the main thread spins for 5 seconds, first
+   with no other threads and then with 1,000 threads that are
+   blocked on a semaphore.
+
+   Before the scheduler updated recent_cpu and priority
+   incrementally, every 4th tick and every second walked all
+   1,000 threads from the interrupt handler.  Now the blocked
+   threads are only touched again when they wake up, so the two
+   measurements should cost about the same.
+
+   The handler cost is only measured in a kernel built with
+   `make TIMERSTAT=1'. */
+
+#include <stdio.h>
+#include "devices/timer.h"
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+#define THREAD_CNT 1000
+#define SPIN_SECONDS 5
+
+static thread_func blocked_thread;
+static void spin(int blocked_cnt);
+
+void test_bench_mlfqs_tick(void) {
+  struct semaphore gate, done;
+  void *aux[2] = {&gate, &done};
+  int i;
+
+  ASSERT(thread_mlfqs);
+
+  sema_init(&gate, 0);
+  sema_init(&done, 0);
+
+  spin(0);
+
+  msg("creating %d threads that block on a semaphore.", THREAD_CNT);
+  for (i = 0; i < THREAD_CNT; i++) {
+    char name[16];
+
+    snprintf(name, sizeof name, "blocked %d", i);
+    if (thread_create(name, PRI_DEFAULT, blocked_thread, aux) == TID_ERROR)
+      fail("thread_create failed for thread %d", i);
+  }
+
+  /* Let every thread run once and block. */
+  timer_sleep(TIMER_FREQ);
+
+  spin(THREAD_CNT);
+
+  for (i = 0; i < THREAD_CNT; i++) sema_up(&gate);
+  for (i = 0; i < THREAD_CNT; i++) sema_down(&done);
+
+  pass();
+}
+
+/* Spins for SPIN_SECONDS and reports the timer interrupt's cost
+   meanwhile, with BLOCKED_CNT threads blocked. */
+static void spin(int blocked_cnt) {
+  struct timer_handler_stats stats;
+  int64_t start_time;
+
+  msg("spinning for %d seconds with %d blocked threads...", SPIN_SECONDS,
+      blocked_cnt);
+  timer_reset_handler_stats();
+  start_time = timer_ticks();
+  while (timer_elapsed(start_time) < SPIN_SECONDS * TIMER_FREQ) continue;
+  timer_get_handler_stats(&stats);
+
+  if (stats.calls > 0)
+    msg("timer interrupt with %d blocked threads: %llu ticks, "
+        "%llu cycles/tick avg, %llu cycles max.",
+        blocked_cnt, stats.calls, stats.total_cycles / stats.calls,
+        stats.max_cycles);
+  else
+    msg("timer interrupt cost not measured (build with TIMERSTAT=1).");
+}
+
+static void blocked_thread(void *aux_) {
+  struct semaphore **aux = aux_;
+
+  sema_down(aux[0]);
+  sema_up(aux[1]);
+}
@@ -0,0 +1,35 @@
+# -*- perl -*-
+
+# With recent_cpu and priority recomputed incrementally, 1,000
+# blocked threads must not make the timer interrupt noticeably more
+# expensive than no blocked threads at all.  Walking all of them
+# every 4th tick would cost several times as much.  Needs a kernel
+# built with `make TIMERSTAT=1'.
+
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+common_checks ("run", @output);
+
+@output = get_core_output ("run", @output);
+fail "missing PASS in output"
+  unless grep ($_ eq '(bench-mlfqs-tick) PASS', @output);
+fail "timer interrupt cost not measured, build with `make TIMERSTAT=1'\n"
+  if grep (/cost not measured/, @output);
+
+my (%avg);
+foreach (@output) {
+    $avg{$1} = $2
+      if /^\(bench-mlfqs-tick\) timer interrupt with (\d+) blocked threads: \d+ ticks, (\d+) cycles\/tick avg/;
+}
+fail "missing timer interrupt cost in output\n"
+  if !defined $avg{0} || !defined $avg{1000};
+fail "timer interrupt took $avg{1000} cycles/tick with 1000 blocked "
+  . "threads, more than twice the $avg{0} with none\n"
+  if $avg{1000} > 2 * $avg{0};
+
+pass;
@@ -38,6 +38,16 @@ static const struct test tests[] =
     {"mlfqs-nice-2", test_mlfqs_nice_2},
     {"mlfqs-nice-10", test_mlfqs_nice_10},
     {"mlfqs-block", test_mlfqs_block},
+    {"alarm-stress", test_alarm_stress},
+    {"bench-ready-queue", test_bench_ready_queue},
+    {"bench-lock-donate", test_bench_lock_donate},
+    {"bench-lock-fast", test_bench_lock_fast},
+    {"bench-palloc", test_bench_palloc},
+    {"bench-bitmap", test_bench_bitmap},
+    {"bench-malloc", test_bench_malloc},
+    {"bench-string", test_bench_string},
+    {"bench-mlfqs-tick", test_bench_mlfqs_tick},
+    {"bench-cfs-fair", test_bench_cfs_fair},
   };
 
 static const char *test_name;
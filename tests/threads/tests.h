@@ -32,6 +32,16 @@ extern test_func test_mlfqs_fair_20;
 extern test_func test_mlfqs_nice_2;
 extern test_func test_mlfqs_nice_10;
 extern test_func test_mlfqs_block;
+extern test_func test_alarm_stress;
+extern test_func test_bench_ready_queue;
+extern test_func test_bench_lock_donate;
+extern test_func test_bench_lock_fast;
+extern test_func test_bench_palloc;
+extern test_func test_bench_bitmap;
+extern test_func test_bench_malloc;
+extern test_func test_bench_string;
+extern test_func test_bench_mlfqs_tick;
+extern test_func test_bench_cfs_fair;
 
 void msg (const char *, ...);
 void fail (const char *, ...);
@@ -0,0 +1,42 @@
+/* Measures how long it takes to run a program whose data segment
+   is read in page by page on demand.
+
+   Each round forks, execs child-large, which touches every page of
+   a 2 MB initialized array, and waits for it.  Run it once normally
+   and once with `-fault-around=1' on the kernel command line to
+   compare against loading a single page per fault; the kernel
+   prints how many faults it took at power off. */
+
+#include <stdint.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define ROUNDS 4
+
+void
+test_main (void)
+{
+  uint64_t total = 0;
+  int round;
+
+  for (round = 0; round < ROUNDS; round++)
+    {
+      uint64_t start = rdtsc ();
+      pid_t child = fork ("child-large");
+
+      if (child == 0)
+        {
+          exec ("child-large");
+          fail ("failed to exec child-large");
+        }
+      if (child < 0)
+        fail ("fork failed");
+      if (wait (child) != 0x42)
+        fail ("child-large exited abnormally");
+      total += rdtsc () - start;
+    }
+
+  msg ("exec of child-large: %llu cycles avg over %d runs",
+       total / ROUNDS, ROUNDS);
+}
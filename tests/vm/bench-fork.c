@@ -0,0 +1,56 @@
+/* Measures fork() latency against the size of the address space.
+
+   Before each round the parent writes to every page of the first
+   SIZE bytes of a BSS array, so that they are resident, then times
+   fork() from the call until it returns in the parent.  The child
+   exits at once.  With copy-on-write the child shares the parent's
+   frames, so the latency should grow with the number of pages but
+   not with their contents. */
+
+#include <stdint.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define ONE_MB (1024 * 1024)
+#define MAX_SIZE (8 * ONE_MB)
+#define ROUNDS 8
+
+static char big_chunks[MAX_SIZE];
+
+static const size_t sizes[] = {0, ONE_MB / 4, ONE_MB, 2 * ONE_MB, 4 * ONE_MB,
+                               MAX_SIZE};
+
+void
+test_main (void)
+{
+  size_t i, j;
+  int round;
+
+  for (i = 0; i < sizeof sizes / sizeof *sizes; i++)
+    {
+      uint64_t total = 0;
+
+      for (j = 0; j < sizes[i]; j += PAGE_SIZE)
+        big_chunks[j] = (char) j;
+
+      for (round = 0; round < ROUNDS; round++)
+        {
+          uint64_t start = rdtsc ();
+          pid_t child = fork ("child");
+
+          if (child == 0)
+            exit (0);
+          total += rdtsc () - start;
+
+          if (child < 0)
+            fail ("fork failed");
+          if (wait (child) != 0)
+            fail ("child exited abnormally");
+        }
+
+      msg ("fork with %zu KB resident: %llu cycles avg over %d forks",
+           sizes[i] / 1024, total / ROUNDS, ROUNDS);
+    }
+}
@@ -0,0 +1,104 @@
+/* Scans a 2 MB file through mmap() with and without madvise() hints.
+
+   Each hint gets a fresh mapping of large.txt.  A sequential scan
+   with MADV_SEQUENTIAL reads ahead a full fault-around window and
+   releases the pages it has passed, so only a few windows stay
+   resident; random reads with MADV_RANDOM load one page per fault.
+   MADV_WILLNEED reads the whole file before the scan and
+   MADV_DONTNEED releases it afterwards.  The kernel prints at power
+   off how many pages madvise() prefetched and released and the peak
+   number of user frames in use. */
+
+#include <stdint.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define RANDOM_CNT 1024
+#define MAP_ADDR ((char *) 0x10000000)
+
+static int handle;
+static size_t size;
+
+static char *
+map_file (int advice)
+{
+  char *map = mmap (MAP_ADDR, size, 0, handle, 0);
+
+  if (map == MAP_FAILED)
+    fail ("mmap \"large.txt\" failed");
+  if (advice != MADV_NORMAL && madvise (map, size, advice) != 0)
+    fail ("madvise %d failed", advice);
+  return map;
+}
+
+static uint64_t
+scan (const char *name, int advice)
+{
+  char *map = map_file (advice);
+  uint64_t start = rdtsc (), sum = 0;
+  size_t i;
+
+  for (i = 0; i < size; i++)
+    sum += (unsigned char) map[i];
+  msg ("%s scan: %llu cycles", name, rdtsc () - start);
+  munmap (map);
+  return sum;
+}
+
+static uint64_t
+random_reads (const char *name, int advice)
+{
+  char *map = map_file (advice);
+  uint64_t start = rdtsc (), sum = 0;
+  unsigned seed = 1;
+  size_t i;
+
+  for (i = 0; i < RANDOM_CNT; i++)
+    {
+      seed = seed * 1103515245 + 12345;
+      sum += (unsigned char) map[(seed >> 8) % (size / PAGE_SIZE) * PAGE_SIZE];
+    }
+  msg ("%s random: %llu cycles", name, rdtsc () - start);
+  munmap (map);
+  return sum;
+}
+
+void
+test_main (void)
+{
+  uint64_t sum, start;
+  char *map;
+  size_t i;
+
+  CHECK ((handle = open ("large.txt")) > 1, "open \"large.txt\"");
+  size = filesize (handle);
+
+  sum = scan ("plain", MADV_NORMAL);
+  if (scan ("MADV_SEQUENTIAL", MADV_SEQUENTIAL) != sum)
+    fail ("MADV_SEQUENTIAL scan disagrees");
+
+  sum = random_reads ("plain", MADV_NORMAL);
+  if (random_reads ("MADV_RANDOM", MADV_RANDOM) != sum)
+    fail ("MADV_RANDOM reads disagree");
+
+  map = map_file (MADV_NORMAL);
+  start = rdtsc ();
+  if (madvise (map, size, MADV_WILLNEED) != 0)
+    fail ("madvise MADV_WILLNEED failed");
+  msg ("MADV_WILLNEED: %llu cycles", rdtsc () - start);
+  start = rdtsc ();
+  for (sum = i = 0; i < size; i += PAGE_SIZE)
+    sum += (unsigned char) map[i];
+  msg ("touch after MADV_WILLNEED: %llu cycles", rdtsc () - start);
+  if (sum == 0)
+    fail ("\"large.txt\" reads as zeros");
+  if (madvise (map, size, MADV_DONTNEED) != 0)
+    fail ("madvise MADV_DONTNEED failed");
+  munmap (map);
+
+  CHECK (madvise (MAP_ADDR, PAGE_SIZE, MADV_NORMAL) == -1,
+         "madvise outside a mapping fails");
+  close (handle);
+}
@@ -0,0 +1,106 @@
+/* Compares reading a 2 MB file through mmap() with read().
+
+   Each method first sums every byte of large.txt sequentially,
+   then reads one byte from each of RANDOM_CNT pages picked with a
+   simple linear congruential generator.  Finally it maps the file
+   writable, changes one byte in every 16th page, and unmaps it;
+   the kernel prints at power off how many dirty pages it wrote
+   back and how many clean pages it skipped. */
+
+#include <stdint.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define RANDOM_CNT 1024
+#define MAP_ADDR ((char *) 0x10000000)
+
+static char buf[PAGE_SIZE];
+
+static unsigned
+next_page (unsigned *seed, size_t page_cnt)
+{
+  *seed = *seed * 1103515245 + 12345;
+  return (*seed >> 8) % page_cnt;
+}
+
+void
+test_main (void)
+{
+  int handle;
+  size_t size, page_cnt, i;
+  unsigned seed;
+  uint64_t start, sum_read = 0, sum_mmap = 0;
+  char *map;
+  int n;
+
+  CHECK ((handle = open ("large.txt")) > 1, "open \"large.txt\"");
+  size = filesize (handle);
+  page_cnt = size / PAGE_SIZE;
+
+  /* Sequential scan. */
+  start = rdtsc ();
+  while ((n = read (handle, buf, sizeof buf)) > 0)
+    for (i = 0; i < (size_t) n; i++)
+      sum_read += (unsigned char) buf[i];
+  msg ("read() scan: %llu cycles", rdtsc () - start);
+
+  map = mmap (MAP_ADDR, size, 0, handle, 0);
+  if (map == MAP_FAILED)
+    fail ("mmap \"large.txt\" failed");
+  start = rdtsc ();
+  for (i = 0; i < size; i++)
+    sum_mmap += (unsigned char) map[i];
+  msg ("mmap() scan: %llu cycles", rdtsc () - start);
+  if (sum_read != sum_mmap)
+    fail ("read() and mmap() disagree");
+  munmap (map);
+
+  /* Random page reads. */
+  sum_read = sum_mmap = 0;
+  seed = 1;
+  start = rdtsc ();
+  for (i = 0; i < RANDOM_CNT; i++)
+    {
+      seek (handle, next_page (&seed, page_cnt) * PAGE_SIZE);
+      if (read (handle, buf, 1) != 1)
+        fail ("read failed");
+      sum_read += (unsigned char) buf[0];
+    }
+  msg ("read() random: %llu cycles", rdtsc () - start);
+
+  map = mmap (MAP_ADDR, size, 0, handle, 0);
+  if (map == MAP_FAILED)
+    fail ("mmap \"large.txt\" failed");
+  seed = 1;
+  start = rdtsc ();
+  for (i = 0; i < RANDOM_CNT; i++)
+    sum_mmap += (unsigned char) map[next_page (&seed, page_cnt) * PAGE_SIZE];
+  msg ("mmap() random: %llu cycles", rdtsc () - start);
+  if (sum_read != sum_mmap)
+    fail ("read() and mmap() disagree");
+  munmap (map);
+
+  /* Write back only the pages that were changed. */
+  map = mmap (MAP_ADDR, size, 1, handle, 0);
+  if (map == MAP_FAILED)
+    fail ("mmap \"large.txt\" writable failed");
+  for (i = 0; i < size; i += PAGE_SIZE)
+    sum_mmap += map[i];
+  for (i = 0; i < page_cnt; i += 16)
+    map[i * PAGE_SIZE] = '#';
+  if (msync (map, size) != 0)
+    fail ("msync failed");
+  start = rdtsc ();
+  munmap (map);
+  msg ("munmap() after msync(): %llu cycles", rdtsc () - start);
+
+  for (i = 0; i < page_cnt; i += 16)
+    {
+      seek (handle, i * PAGE_SIZE);
+      if (read (handle, buf, 1) != 1 || buf[0] != '#')
+        fail ("page %zu was not written back", i);
+    }
+  close (handle);
+}
@@ -0,0 +1,68 @@
+/* Measures exec() and fork() of processes with a large, sparsely
+   used address space.
+
+   Both this program and child-sparse have a 64 MB BSS array of
+   which they touch one page per megabyte.  The first half times
+   fork+exec+wait of child-sparse; the second half times fork()
+   of this process.  Neither should cost more than the pages that
+   are actually in use.  The kernel prints the peak number of page
+   and area structures at power off. */
+
+#include <stdint.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define ONE_MB (1024 * 1024)
+#define SIZE (64 * ONE_MB)
+#define ROUNDS 8
+
+static char sparse[SIZE];
+
+void
+test_main (void)
+{
+  uint64_t exec_total = 0, fork_total = 0;
+  size_t i;
+  int round;
+
+  for (round = 0; round < ROUNDS; round++)
+    {
+      uint64_t start = rdtsc ();
+      pid_t child = fork ("child-sparse");
+
+      if (child == 0)
+        {
+          exec ("child-sparse");
+          fail ("failed to exec child-sparse");
+        }
+      if (child < 0)
+        fail ("fork failed");
+      if (wait (child) != 0x42)
+        fail ("child-sparse exited abnormally");
+      exec_total += rdtsc () - start;
+    }
+
+  for (i = 0; i < SIZE; i += ONE_MB)
+    sparse[i] = 1;
+
+  for (round = 0; round < ROUNDS; round++)
+    {
+      uint64_t start = rdtsc ();
+      pid_t child = fork ("child");
+
+      if (child == 0)
+        exit (0);
+      fork_total += rdtsc () - start;
+
+      if (child < 0)
+        fail ("fork failed");
+      if (wait (child) != 0)
+        fail ("child exited abnormally");
+    }
+
+  msg ("exec of a 64 MB sparse image: %llu cycles avg over %d runs",
+       exec_total / ROUNDS, ROUNDS);
+  msg ("fork of a 64 MB sparse image: %llu cycles avg over %d forks",
+       fork_total / ROUNDS, ROUNDS);
+}
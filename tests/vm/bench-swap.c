@@ -0,0 +1,46 @@
+/* Measures swap throughput.
+
+   Pintos runs with 10 MB of memory, so writing one byte to each
+   page of a 20 MB array forces the kernel to swap out about half
+   of the pages, and reading them back afterwards swaps them in
+   again.  Each pass reports the average cycles per page; the
+   kernel's "Swap:" statistics at power off give pages per second
+   and how many disk writes the swap outs took. */
+
+#include <stdint.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define CHUNK_SIZE (20 * 1024 * 1024)
+#define PAGE_COUNT (CHUNK_SIZE / PAGE_SIZE)
+#define PASSES 2
+
+static char big_chunks[CHUNK_SIZE];
+
+void
+test_main (void)
+{
+  uint64_t start, cycles;
+  size_t i;
+  int pass;
+
+  for (pass = 0; pass < PASSES; pass++)
+    {
+      start = rdtsc ();
+      for (i = 0; i < PAGE_COUNT; i++)
+        big_chunks[i * PAGE_SIZE] = (char) (i + pass);
+      cycles = rdtsc () - start;
+      msg ("pass %d: wrote %d pages, %llu cycles/page", pass, PAGE_COUNT,
+           cycles / PAGE_COUNT);
+
+      start = rdtsc ();
+      for (i = 0; i < PAGE_COUNT; i++)
+        if (big_chunks[i * PAGE_SIZE] != (char) (i + pass))
+          fail ("data is inconsistent in page %zu", i);
+      cycles = rdtsc () - start;
+      msg ("pass %d: read %d pages, %llu cycles/page", pass, PAGE_COUNT,
+           cycles / PAGE_COUNT);
+    }
+}
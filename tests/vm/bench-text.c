@@ -0,0 +1,40 @@
+/* Runs several instances of child-text at once.
+
+   Each instance maps 1 MB of read-only data from the same
+   executable.  When those pages are shared through the kernel's
+   text cache, the peak number of user frames that the kernel
+   prints at power off grows by the private pages of each
+   instance only, not by another 256 text pages. */
+
+#include <stdint.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define CHILD_CNT 8
+
+void
+test_main (void)
+{
+  pid_t children[CHILD_CNT];
+  uint64_t start = rdtsc ();
+  int i;
+
+  for (i = 0; i < CHILD_CNT; i++)
+    {
+      children[i] = fork ("child-text");
+      if (children[i] == 0)
+        {
+          exec ("child-text");
+          fail ("failed to exec child-text");
+        }
+      if (children[i] < 0)
+        fail ("fork failed");
+    }
+  for (i = 0; i < CHILD_CNT; i++)
+    if (wait (children[i]) != 0x42)
+      fail ("child-text %d exited abnormally", i);
+
+  msg ("%d instances of child-text: %llu cycles", CHILD_CNT,
+       rdtsc () - start);
+}
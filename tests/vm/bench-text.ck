@@ -0,0 +1,38 @@
+# -*- perl -*-
+
+# Each of the 8 child-text instances reads 256 pages of read-only
+# data.  Shared through the text cache, those pages are in memory
+# once, so the kernel's power-off statistics must show text cache
+# hits and a frame peak far below the 8 * 256 frames that private
+# copies would need.
+
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+common_checks ("run", @output);
+
+my ($child_cnt) = 8;
+my ($text_pages) = 256;
+
+my ($hits) = map (/^VM: (\d+) text pages mapped from the text cache/,
+		  @output);
+fail "missing text cache statistics in output\n" if !defined $hits;
+fail "only $hits text pages came from the text cache, "
+  . "expected at least $text_pages\n"
+  if $hits < $text_pages;
+
+my ($peak) = map (/^VM: \d+ user frames in use \(peak (\d+)\)/, @output);
+fail "missing frame statistics in output\n" if !defined $peak;
+fail "peak of $peak user frames, expected fewer than "
+  . ($child_cnt * $text_pages / 2) . "\n"
+  if $peak >= $child_cnt * $text_pages / 2;
+
+@output = get_core_output ("run", @output);
+fail "missing end in output"
+  unless grep ($_ eq '(bench-text) end', @output);
+
+pass;
@@ -0,0 +1,42 @@
+/* Reads a large BSS array that is never written, then writes a few
+   of its pages.
+
+   Every page of the array is zero-filled on demand.  Reading it
+   should not need a frame per page: the kernel prints at power off
+   how many read faults it served with its shared zero page and the
+   peak number of user frames in use. */
+
+#include <stdint.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define ONE_MB (1024 * 1024)
+#define SIZE (16 * ONE_MB)
+
+static char zeros[SIZE];
+
+void
+test_main (void)
+{
+  uint64_t start;
+  size_t i;
+  int sum = 0;
+
+  start = rdtsc ();
+  for (i = 0; i < SIZE; i += PAGE_SIZE)
+    sum += zeros[i];
+  msg ("read %d pages: %llu cycles", SIZE / PAGE_SIZE, rdtsc () - start);
+  if (sum != 0)
+    fail ("BSS is not zero");
+
+  start = rdtsc ();
+  for (i = 0; i < SIZE; i += ONE_MB)
+    zeros[i + 1] = 1;
+  msg ("wrote %d pages: %llu cycles", SIZE / ONE_MB, rdtsc () - start);
+
+  for (i = 0; i < SIZE; i += ONE_MB)
+    if (zeros[i] != 0 || zeros[i + 1] != 1)
+      fail ("page at %zu MB is corrupted", i / ONE_MB);
+}
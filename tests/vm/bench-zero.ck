@@ -0,0 +1,42 @@
+# -*- perl -*-
+
+# bench-zero reads 4096 pages of BSS and writes 16 of them.  The
+# reads must be served by the kernel's shared zero page, so its
+# power-off statistics must count a zero page mapping for each read
+# page and a frame peak far below one frame per page.  The first
+# page of the array may share a page with initialized data, which is
+# read from the executable instead.
+
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+common_checks ("run", @output);
+
+my ($pages) = 4096;
+my ($written) = 16;
+
+my ($zero_maps, $zero_breaks)
+  = map (/^VM: (\d+) read faults mapped the zero page, (\d+) of them/,
+	 @output);
+fail "missing zero page statistics in output\n" if !defined $zero_maps;
+fail "only $zero_maps read faults mapped the zero page, "
+  . "expected at least " . ($pages - 1) . "\n"
+  if $zero_maps < $pages - 1;
+fail "only $zero_breaks zero page mappings were written, "
+  . "expected at least " . ($written - 1) . "\n"
+  if $zero_breaks < $written - 1;
+
+my ($peak) = map (/^VM: \d+ user frames in use \(peak (\d+)\)/, @output);
+fail "missing frame statistics in output\n" if !defined $peak;
+fail "peak of $peak user frames, expected fewer than " . ($pages / 4) . "\n"
+  if $peak >= $pages / 4;
+
+@output = get_core_output ("run", @output);
+fail "missing end in output"
+  unless grep ($_ eq '(bench-zero) end', @output);
+
+pass;
@@ -0,0 +1,25 @@
+/* Child process of bench-exec.
+   Reads one byte from every page of the 2 MB `large' array, which
+   lives in the initialized data segment and so is loaded lazily
+   from the executable, then exits with 0x42. */
+
+#include <stddef.h>
+#include "tests/lib.h"
+#include "tests/vm/large.inc"
+
+const char *test_name = "child-large";
+
+#define PAGE_SIZE 4096
+
+int
+main (void)
+{
+  size_t i;
+  char sum = 0;
+
+  for (i = 0; i < sizeof large; i += PAGE_SIZE)
+    sum += large[i];
+  if (sum == 0 && large[0] == 0)
+    fail ("large is empty");
+  return 0x42;
+}
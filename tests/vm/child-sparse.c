@@ -0,0 +1,26 @@
+/* Child process of bench-sparse.
+   Writes one page in every megabyte of a 64 MB BSS array, then
+   exits with 0x42.  Only 64 of its 16384 pages are ever touched. */
+
+#include <stddef.h>
+#include "tests/lib.h"
+
+const char *test_name = "child-sparse";
+
+#define ONE_MB (1024 * 1024)
+#define SIZE (64 * ONE_MB)
+
+static char sparse[SIZE];
+
+int
+main (void)
+{
+  size_t i;
+
+  for (i = 0; i < SIZE; i += ONE_MB)
+    sparse[i] = (char) (i / ONE_MB);
+  for (i = 0; i < SIZE; i += ONE_MB)
+    if (sparse[i] != (char) (i / ONE_MB))
+      fail ("data is inconsistent");
+  return 0x42;
+}
@@ -0,0 +1,33 @@
+/* Child process of bench-text.
+   Reads every page of a 1 MB read-only array, which the linker
+   places in the text segment, then spins for a while so that all
+   instances are alive at once, and exits with 0x42. */
+
+#include <stddef.h>
+#include "tests/lib.h"
+
+const char *test_name = "child-text";
+
+#define PAGE_SIZE 4096
+#define SIZE (1024 * 1024)
+#define SPIN (1 << 24)
+
+/* Initialized, so that it is stored in the executable. */
+static const char text[SIZE] = {1};
+
+int
+main (void)
+{
+  volatile size_t spin;
+  size_t i;
+  int sum = 0;
+
+  for (i = 0; i < SIZE; i += PAGE_SIZE)
+    sum += text[i];
+  if (sum != 1)
+    fail ("text is corrupted");
+
+  for (spin = 0; spin < SPIN; spin++)
+    continue;
+  return 0x42;
+}
@@ -0,0 +1,250 @@
+#include "threads/heapprof.h"
+#include <debug.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "threads/interrupt.h"
+
+#ifdef HEAPPROF
+/* Live allocations are kept in a fixed-size hash table indexed
+   by address, with linear probing, so that recording one never
+   allocates memory itself.  The table is only ever touched with
+   interrupts disabled, which makes it safe to use from any
+   allocator and from interrupt handlers.
+
+   Reports group the live allocations by call site into a second,
+   smaller table and print the sites with the most live bytes. */
+
+/* Number of live allocations that can be recorded.  Must be a
+   power of 2. */
+#define ALLOC_SLOTS 16384
+
+/* Number of distinct call sites a report can group.  Must be a
+   power of 2. */
+#define SITE_SLOTS 1024
+
+/* Number of call sites printed per report. */
+#define TOP_SITES 10
+
+/* A live allocation. */
+struct alloc {
+	const void *ptr;            /* Block, or NULL if the slot is free. */
+	const void *site;           /* Return address of the allocating call. */
+	uint32_t size : 30;         /* Size in bytes. */
+	uint32_t kind : 2;          /* enum heapprof_kind. */
+	tid_t tid;                  /* Thread that allocated it. */
+};
+
+/* Live allocations from one call site. */
+struct site {
+	const void *site;           /* Return address, or NULL if unused. */
+	enum heapprof_kind kind;    /* Kind of allocation. */
+	size_t cnt;                 /* Number of live allocations. */
+	size_t bytes;               /* Their total size. */
+};
+
+static struct alloc allocs[ALLOC_SLOTS];
+static struct site sites[SITE_SLOTS];
+
+static size_t live_cnt;         /* Number of live allocations. */
+static size_t live_bytes;       /* Their total size. */
+static size_t peak_bytes;       /* Maximum of LIVE_BYTES. */
+static size_t dropped_cnt;      /* Allocations not recorded, table full. */
+
+static const char *kind_names[] = {"malloc", "slab", "palloc"};
+
+/* -heapprof: record allocations? */
+bool heapprof;
+
+/* Returns the hash table slot at which to start looking for
+   address P in a table of SLOT_CNT slots. */
+static size_t
+hash_ptr (const void *p, size_t slot_cnt) {
+	uint64_t x = (uint64_t) p >> 4;
+	return (x * 0x9e3779b97f4a7c15ULL >> 32) & (slot_cnt - 1);
+}
+
+/* Records that PTR, SIZE bytes of KIND, was just allocated by the
+   call that returns to SITE.  A null PTR, from a failed
+   allocation, is ignored. */
+void
+heapprof_alloc (enum heapprof_kind kind, const void *ptr, size_t size,
+		const void *site) {
+	enum intr_level old_level;
+	size_t i, probes;
+
+	if (!heapprof || ptr == NULL)
+		return;
+
+	old_level = intr_disable ();
+	i = hash_ptr (ptr, ALLOC_SLOTS);
+	for (probes = 0; probes < ALLOC_SLOTS; probes++) {
+		struct alloc *a = &allocs[i];
+
+		if (a->ptr == NULL) {
+			a->ptr = ptr;
+			a->site = site;
+			a->size = size;
+			a->kind = kind;
+			a->tid = thread_current ()->tid;
+			live_cnt++;
+			live_bytes += size;
+			if (live_bytes > peak_bytes)
+				peak_bytes = live_bytes;
+			break;
+		}
+		i = (i + 1) & (ALLOC_SLOTS - 1);
+	}
+	if (probes == ALLOC_SLOTS)
+		dropped_cnt++;
+	intr_set_level (old_level);
+}
+
+/* Records that PTR is being freed.  Blocks that were never
+   recorded, such as the pages that back malloc() and the slab
+   caches, are ignored. */
+void
+heapprof_free (const void *ptr) {
+	enum intr_level old_level;
+	size_t i, probes;
+
+	if (!heapprof || ptr == NULL)
+		return;
+
+	old_level = intr_disable ();
+	i = hash_ptr (ptr, ALLOC_SLOTS);
+	for (probes = 0; probes < ALLOC_SLOTS && allocs[i].ptr != NULL; probes++) {
+		if (allocs[i].ptr == ptr) {
+			size_t hole = i, j = i;
+
+			live_cnt--;
+			live_bytes -= allocs[i].size;
+
+			/* Backward-shift deletion: move later entries of the
+			   probe run into the hole, unless that would put them
+			   before their home slot. */
+			for (;;) {
+				size_t home;
+
+				j = (j + 1) & (ALLOC_SLOTS - 1);
+				if (allocs[j].ptr == NULL)
+					break;
+				home = hash_ptr (allocs[j].ptr, ALLOC_SLOTS);
+				if (((j - home) & (ALLOC_SLOTS - 1))
+						>= ((j - hole) & (ALLOC_SLOTS - 1))) {
+					allocs[hole] = allocs[j];
+					hole = j;
+				}
+			}
+			allocs[hole].ptr = NULL;
+			break;
+		}
+		i = (i + 1) & (ALLOC_SLOTS - 1);
+	}
+	intr_set_level (old_level);
+}
+
+/* Groups the live allocations owned by thread TID, or all of them
+   if TID is TID_ERROR, by call site into SITES[].  Returns the
+   number of allocations grouped.  Interrupts must be off. */
+static size_t
+group_sites (tid_t tid) {
+	size_t i, cnt = 0;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	memset (sites, 0, sizeof sites);
+	for (i = 0; i < ALLOC_SLOTS; i++) {
+		const struct alloc *a = &allocs[i];
+		size_t j, probes;
+
+		if (a->ptr == NULL || (tid != TID_ERROR && a->tid != tid))
+			continue;
+		cnt++;
+
+		j = hash_ptr (a->site, SITE_SLOTS);
+		for (probes = 0; probes < SITE_SLOTS; probes++) {
+			struct site *s = &sites[j];
+
+			if (s->site == NULL) {
+				s->site = a->site;
+				s->kind = a->kind;
+			}
+			if (s->site == a->site) {
+				s->cnt++;
+				s->bytes += a->size;
+				break;
+			}
+			j = (j + 1) & (SITE_SLOTS - 1);
+		}
+	}
+	return cnt;
+}
+
+/* Prints the TOP_SITES call sites in SITES[] with the most live
+   bytes, largest first.  Destroys SITES[].  Interrupts must be
+   off. */
+static void
+print_top_sites (void) {
+	int n;
+
+	for (n = 0; n < TOP_SITES; n++) {
+		struct site *top = NULL;
+		size_t i;
+
+		for (i = 0; i < SITE_SLOTS; i++)
+			if (sites[i].cnt > 0 && (top == NULL || sites[i].bytes > top->bytes))
+				top = &sites[i];
+		if (top == NULL)
+			break;
+
+		printf ("  %p %-6s %8zu bytes in %zu blocks\n",
+				top->site, kind_names[top->kind], top->bytes, top->cnt);
+		top->cnt = 0;
+	}
+}
+
+/* Prints the allocations that thread TID, which is exiting, made
+   and never freed, by call site.  Prints nothing if there are
+   none. */
+void
+heapprof_print_leaks (tid_t tid) {
+	enum intr_level old_level;
+	size_t cnt;
+
+	if (!heapprof)
+		return;
+
+	old_level = intr_disable ();
+	cnt = group_sites (tid);
+	if (cnt > 0) {
+		printf ("heapprof: thread %d exits with %zu live allocations:\n",
+				tid, cnt);
+		print_top_sites ();
+	}
+	intr_set_level (old_level);
+}
+
+/* Prints heap profiling statistics: the live and peak heap size
+   and the call sites with the most live bytes. */
+void
+heapprof_print_stats (void) {
+	enum intr_level old_level;
+
+	if (!heapprof)
+		return;
+
+	old_level = intr_disable ();
+	printf ("Heap profile: %zu live allocations, %zu bytes live, "
+			"%zu bytes peak, %zu not recorded.\n",
+			live_cnt, live_bytes, peak_bytes, dropped_cnt);
+	if (group_sites (TID_ERROR) > 0) {
+		printf ("Top allocation sites by live bytes:\n");
+		print_top_sites ();
+		printf ("Run `backtrace ADDR...' in the build directory "
+				"to name the sites.\n");
+	}
+	intr_set_level (old_level);
+}
+
+#endif /* HEAPPROF */
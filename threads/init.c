@@ -20,6 +20,9 @@
 #include "threads/mmu.h"
 #include "threads/palloc.h"
 #include "threads/pte.h"
+#include "threads/slab.h"
+#include "threads/heapprof.h"
+#include "threads/synch.h"
 #include "threads/thread.h"
 #ifdef USERPROG
 #include "userprog/exception.h"
@@ -84,6 +87,7 @@ int main(void) {
   /* Initialize memory system. */
   mem_end = palloc_init();
   malloc_init();
+  slab_init(); /* added for slab allocator */
   paging_init(mem_end);
 
 #ifdef USERPROG
@@ -213,11 +217,44 @@ static char **parse_options(char **argv) {
       random_init(atoi(value));
     else if (!strcmp(name, "-mlfqs"))
       thread_mlfqs = true;
+    else if (!strcmp(name, "-lockstat")) {
+      /* added for lock statistics */
+#ifdef LOCKSTAT
+      lockstat = true;
+#else
+      printf("-lockstat: lock statistics not built in (make LOCKSTAT=1)\n");
+#endif
+    }
+    else if (!strcmp(name, "-heapprof")) {
+      /* added for heap profiler */
+#ifdef HEAPPROF
+      heapprof = true;
+#else
+      printf("-heapprof: heap profiler not built in (make HEAPPROF=1)\n");
+#endif
+    }
+    else if (!strcmp(name, "-sched")) {
+      /* added for CFS : -sched=priority|mlfqs|cfs */
+      if (value == NULL) PANIC("-sched requires a scheduler name");
+      thread_mlfqs = !strcmp(value, "mlfqs");
+      thread_cfs = !strcmp(value, "cfs");
+      if (!thread_mlfqs && !thread_cfs && strcmp(value, "priority"))
+        PANIC("unknown scheduler `%s' (use -h for help)", value);
+    }
 #ifdef USERPROG
     else if (!strcmp(name, "-ul"))
       user_page_limit = atoi(value);
     else if (!strcmp(name, "-threads-tests"))
       thread_tests = true;
+#endif
+#ifdef VM
+    else if (!strcmp(name, "-fault-around")) {
+      /* added for fault-around : -fault-around=1 이면 끈다. */
+      if (value == NULL) PANIC("-fault-around requires a page count");
+      vm_fault_around = atoi(value);
+      if (vm_fault_around < 1 || vm_fault_around > VM_FAULT_AROUND_MAX)
+        PANIC("-fault-around must be between 1 and %d", VM_FAULT_AROUND_MAX);
+    }
 #endif
     else
       PANIC("unknown option `%s' (use -h for help)", name);
@@ -312,8 +349,14 @@ static void usage(void) {
       "  -f                 Format file system disk during startup.\n"
       "  -rs=SEED           Set random number seed to SEED.\n"
       "  -mlfqs             Use multi-level feedback queue scheduler.\n"
+      "  -sched=NAME        Use scheduler NAME: priority, mlfqs or cfs.\n"
+      "  -lockstat          Print lock contention statistics at power off.\n"
+      "  -heapprof          Track live allocations, report leaks and top sites.\n"
 #ifdef USERPROG
       "  -ul=COUNT          Limit user memory to COUNT pages.\n"
+#endif
+#ifdef VM
+      "  -fault-around=N    Load up to N executable pages per page fault.\n"
 #endif
   );
   power_off();
@@ -337,6 +380,11 @@ void power_off(void) {
 static void print_stats(void) {
   timer_print_stats();
   thread_print_stats();
+#ifdef LOCKSTAT
+  lock_print_stats();
+#endif
+  slab_print_stats();
+  heapprof_print_stats();
 #ifdef FILESYS
   disk_print_stats();
 #endif
@@ -345,4 +393,7 @@ static void print_stats(void) {
 #ifdef USERPROG
   exception_print_stats();
 #endif
+#ifdef VM
+  vm_print_stats(); /* added for swap */
+#endif
 }
@@ -5,8 +5,11 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
+#include "threads/heapprof.h"
+#include "threads/interrupt.h"
 #include "threads/palloc.h"
 #include "threads/synch.h"
+#include "threads/thread.h"
 #include "threads/vaddr.h"
 
 /* A simple implementation of malloc().
@@ -28,18 +31,49 @@
    blocks, we remove all of the arena's blocks from the free list
    and give the arena back to the page allocator.
 
+   In front of each descriptor's free list, every CPU keeps a
+   small "magazine" of free blocks of that size.  malloc() and
+   free() normally just pop or push a magazine slot with
+   interrupts disabled, without taking the descriptor's lock.
+   Only when a magazine runs empty or full are MAG_BATCH blocks
+   moved between it and the free list, under the lock at once.
+
+   Freeing an arena costs a walk over all of its blocks, and a
+   workload that allocates and frees in a loop would otherwise
+   give an arena back and get it again over and over.  So each
+   descriptor keeps up to EMPTY_ARENAS_MAX entirely free arenas
+   around before it gives any back to the page allocator.
+
    We can't handle blocks bigger than 2 kB using this scheme,
    because they're too big to fit in a single page with a
    descriptor.  We handle those by allocating contiguous pages
    with the page allocator and sticking the allocation size at
    the beginning of the allocated block's arena header. */
 
+/* Number of blocks a magazine holds. */
+#define MAG_SIZE 16
+
+/* Number of blocks moved between a magazine and its
+   descriptor's free list at once. */
+#define MAG_BATCH (MAG_SIZE / 2)
+
+/* Number of entirely free arenas a descriptor keeps. */
+#define EMPTY_ARENAS_MAX 2
+
+/* Per-CPU cache of free blocks of one size. */
+struct magazine {
+	size_t cnt;                 /* Number of blocks in BLOCKS. */
+	struct block *blocks[MAG_SIZE]; /* Free blocks, a stack. */
+};
+
 /* Descriptor. */
 struct desc {
 	size_t block_size;          /* Size of each element in bytes. */
 	size_t blocks_per_arena;    /* Number of blocks in an arena. */
 	struct list free_list;      /* List of free blocks. */
+	size_t empty_arenas;        /* Arenas with no in-use blocks. */
 	struct lock lock;           /* Lock. */
+	struct magazine mags[NCPU_MAX]; /* Per-CPU magazines. */
 };
 
 /* Magic number for detecting arena corruption. */
@@ -63,6 +97,9 @@ static size_t desc_cnt;         /* Number of descriptors. */
 
 static struct arena *block_to_arena (struct block *);
 static struct block *arena_to_block (struct arena *, size_t idx);
+static void *alloc_block (size_t size);
+static size_t desc_get_blocks (struct desc *, struct block **, size_t cnt);
+static void desc_put_blocks (struct desc *, struct block **, size_t cnt);
 
 /* Initializes the malloc() descriptors. */
 void
@@ -75,6 +112,7 @@ malloc_init (void) {
 		d->block_size = block_size;
 		d->blocks_per_arena = (PGSIZE - sizeof (struct arena)) / block_size;
 		list_init (&d->free_list);
+		d->empty_arenas = 0;
 		lock_init (&d->lock);
 	}
 }
@@ -83,9 +121,24 @@ malloc_init (void) {
    Returns a null pointer if memory is not available. */
 void *
 malloc (size_t size) {
+	void *p = alloc_block (size);
+
+	heapprof_alloc (HEAPPROF_MALLOC, p, size, __builtin_return_address (0));
+	return p;
+}
+
+/* Does the work of malloc(), without recording the block in the
+   heap profiler, so that calloc() and realloc() can record their
+   own callers. */
+static void *
+alloc_block (size_t size) {
 	struct desc *d;
 	struct block *b;
 	struct arena *a;
+	struct magazine *m;
+	struct block *batch[MAG_BATCH];
+	enum intr_level old_level;
+	size_t cnt;
 
 	/* A null pointer satisfies a request for 0 bytes. */
 	if (size == 0)
@@ -100,7 +153,7 @@ malloc (size_t size) {
 		/* SIZE is too big for any descriptor.
 		   Allocate enough pages to hold SIZE plus an arena. */
 		size_t page_cnt = DIV_ROUND_UP (size + sizeof *a, PGSIZE);
-		a = palloc_get_multiple (0, page_cnt);
+		a = palloc_get_multiple (PAL_NOPROF, page_cnt);
 		if (a == NULL)
 			return NULL;
 
@@ -112,35 +165,116 @@ malloc (size_t size) {
 		return a + 1;
 	}
 
+	/* Take a block from this CPU's magazine if it has one. */
+	old_level = intr_disable ();
+	m = &d->mags[this_cpu ()->id];
+	if (m->cnt > 0) {
+		b = m->blocks[--m->cnt];
+		intr_set_level (old_level);
+		return b;
+	}
+	intr_set_level (old_level);
+
+	/* Refill the magazine from the free list.  Another thread on
+	   this CPU may have refilled it in the meantime, in which
+	   case the blocks that do not fit go back. */
+	cnt = desc_get_blocks (d, batch, MAG_BATCH);
+	if (cnt == 0)
+		return NULL;
+	b = batch[--cnt];
+
+	old_level = intr_disable ();
+	m = &d->mags[this_cpu ()->id];
+	while (cnt > 0 && m->cnt < MAG_SIZE)
+		m->blocks[m->cnt++] = batch[--cnt];
+	intr_set_level (old_level);
+
+	if (cnt > 0)
+		desc_put_blocks (d, batch, cnt);
+	return b;
+}
+
+/* Takes up to CNT blocks from D's free list, creating a new arena
+   if the list is empty, and stores them into BLOCKS.  Returns the
+   number of blocks taken, which is 0 only if memory is not
+   available. */
+static size_t
+desc_get_blocks (struct desc *d, struct block **blocks, size_t cnt) {
+	size_t taken;
+
 	lock_acquire (&d->lock);
 
 	/* If the free list is empty, create a new arena. */
 	if (list_empty (&d->free_list)) {
+		struct arena *a;
 		size_t i;
 
 		/* Allocate a page. */
-		a = palloc_get_page (0);
+		a = palloc_get_page (PAL_NOPROF);
 		if (a == NULL) {
 			lock_release (&d->lock);
-			return NULL;
+			return 0;
 		}
 
 		/* Initialize arena and add its blocks to the free list. */
 		a->magic = ARENA_MAGIC;
 		a->desc = d;
 		a->free_cnt = d->blocks_per_arena;
+		d->empty_arenas++;
 		for (i = 0; i < d->blocks_per_arena; i++) {
 			struct block *b = arena_to_block (a, i);
 			list_push_back (&d->free_list, &b->free_elem);
 		}
 	}
 
-	/* Get a block from free list and return it. */
-	b = list_entry (list_pop_front (&d->free_list), struct block, free_elem);
-	a = block_to_arena (b);
-	a->free_cnt--;
+	/* Get blocks from the free list. */
+	for (taken = 0; taken < cnt && !list_empty (&d->free_list); taken++) {
+		struct block *b = list_entry (list_pop_front (&d->free_list),
+				struct block, free_elem);
+		struct arena *a = block_to_arena (b);
+
+		if (a->free_cnt-- == d->blocks_per_arena)
+			d->empty_arenas--;
+		blocks[taken] = b;
+	}
+	lock_release (&d->lock);
+	return taken;
+}
+
+/* Returns the CNT blocks in BLOCKS to D's free list.  Arenas that
+   become entirely free are kept, up to EMPTY_ARENAS_MAX of them,
+   and the rest are given back to the page allocator. */
+static void
+desc_put_blocks (struct desc *d, struct block **blocks, size_t cnt) {
+	size_t i;
+
+	lock_acquire (&d->lock);
+	for (i = 0; i < cnt; i++) {
+		struct block *b = blocks[i];
+		struct arena *a = block_to_arena (b);
+
+		/* Add block to free list. */
+		list_push_front (&d->free_list, &b->free_elem);
+
+		if (++a->free_cnt < d->blocks_per_arena)
+			continue;
+
+		/* The arena is now entirely unused.  Keep it unless we
+		   already have enough such arenas; otherwise free it. */
+		ASSERT (a->free_cnt == d->blocks_per_arena);
+		if (d->empty_arenas < EMPTY_ARENAS_MAX)
+			d->empty_arenas++;
+		else {
+			size_t j;
+
+			for (j = 0; j < d->blocks_per_arena; j++) {
+				struct block *b = arena_to_block (a, j);
+				list_remove (&b->free_elem);
+			}
+			palloc_free_page (a);
+		}
+	}
 	lock_release (&d->lock);
-	return b;
 }
 
 /* Allocates and return A times B bytes initialized to zeroes.
@@ -156,9 +290,10 @@ calloc (size_t a, size_t b) {
 		return NULL;
 
 	/* Allocate and zero memory. */
-	p = malloc (size);
+	p = alloc_block (size);
 	if (p != NULL)
 		memset (p, 0, size);
+	heapprof_alloc (HEAPPROF_MALLOC, p, size, __builtin_return_address (0));
 
 	return p;
 }
@@ -185,7 +320,9 @@ realloc (void *old_block, size_t new_size) {
 		free (old_block);
 		return NULL;
 	} else {
-		void *new_block = malloc (new_size);
+		void *new_block = alloc_block (new_size);
+		heapprof_alloc (HEAPPROF_MALLOC, new_block, new_size,
+				__builtin_return_address (0));
 		if (old_block != NULL && new_block != NULL) {
 			size_t old_size = block_size (old_block);
 			size_t min_size = new_size < old_size ? new_size : old_size;
@@ -205,32 +342,36 @@ free (void *p) {
 		struct arena *a = block_to_arena (b);
 		struct desc *d = a->desc;
 
+		heapprof_free (p);
 		if (d != NULL) {
 			/* It's a normal block.  We handle it here. */
+			struct block *batch[MAG_BATCH];
+			enum intr_level old_level;
+			struct magazine *m;
+			bool flush;
 
 #ifndef NDEBUG
 			/* Clear the block to help detect use-after-free bugs. */
 			memset (b, 0xcc, d->block_size);
 #endif
 
-			lock_acquire (&d->lock);
-
-			/* Add block to free list. */
-			list_push_front (&d->free_list, &b->free_elem);
-
-			/* If the arena is now entirely unused, free it. */
-			if (++a->free_cnt >= d->blocks_per_arena) {
-				size_t i;
-
-				ASSERT (a->free_cnt == d->blocks_per_arena);
-				for (i = 0; i < d->blocks_per_arena; i++) {
-					struct block *b = arena_to_block (a, i);
-					list_remove (&b->free_elem);
-				}
-				palloc_free_page (a);
+			/* Put the block into this CPU's magazine.  If it is
+			   full, move the older half of it to the free list. */
+			old_level = intr_disable ();
+			m = &d->mags[this_cpu ()->id];
+			flush = m->cnt == MAG_SIZE;
+
+			if (flush) {
+				memcpy (batch, m->blocks, sizeof batch);
+				memmove (m->blocks, m->blocks + MAG_BATCH,
+						(MAG_SIZE - MAG_BATCH) * sizeof *m->blocks);
+				m->cnt -= MAG_BATCH;
 			}
+			m->blocks[m->cnt++] = b;
+			intr_set_level (old_level);
 
-			lock_release (&d->lock);
+			if (flush)
+				desc_put_blocks (d, batch, MAG_BATCH);
 		} else {
 			/* It's a big block.  Free its pages. */
 			palloc_free_multiple (a, a->free_cnt);
@@ -2,11 +2,13 @@
 #include <bitmap.h>
 #include <debug.h>
 #include <inttypes.h>
+#include <list.h>
 #include <round.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
+#include "threads/heapprof.h"
 #include "threads/init.h"
 #include "threads/loader.h"
 #include "threads/synch.h"
@@ -24,13 +26,39 @@
 
    By default, half of system RAM is given to the kernel pool and
    half to the user pool.  That should be huge overkill for the
-   kernel pool, but that's just fine for demonstration purposes. */
+   kernel pool, but that's just fine for demonstration purposes.
+
+   Each pool is a binary buddy allocator (Knowlton, "A Fast
+   Storage Allocator", 1965).  Free memory is kept as blocks of
+   2**K pages, for "order" K, each aligned to its own size
+   relative to the pool base.  Every order has a list of its free
+   blocks.  The list elements live in an array beside the bitmap,
+   one per page, rather than in the free pages themselves: at
+   boot only the first 256 MB are mapped, but the pools are
+   populated before paging_init() maps the rest.  A block's
+   buddy is the block of the same order it was split from; when
+   both are free they are merged again.
+   Allocating or freeing a block is thus O(log n) instead of a
+   bitmap scan from the start of the pool.
+
+   A request for a number of pages that is not a power of 2 takes
+   the smallest block that fits and gives the tail back, so
+   callers still free exactly the pages they asked for. */
+
+/* Number of block orders: the largest block is 2**(BUDDY_ORDERS
+   - 1) pages (2 GB). */
+#define BUDDY_ORDERS 20
 
 /* A memory pool. */
 struct pool {
 	struct lock lock;               /* Mutual exclusion. */
 	struct bitmap *used_map;        /* Bitmap of free pages. */
 	uint8_t *base;                  /* Base of pool. */
+	uint8_t *free_order;            /* Per page: 1 + order of the free
+	                                   block starting there, or 0. */
+	struct list_elem *free_elem;    /* Per page: element in a free_list,
+	                                   if a free block starts there. */
+	struct list free_list[BUDDY_ORDERS];  /* Free blocks by order. */
 };
 
 /* Two pools: one for kernel data, one for user pages. */
@@ -42,6 +70,7 @@ static void
 init_pool (struct pool *p, void **bm_base, uint64_t start, uint64_t end);
 
 static bool page_from_pool (const struct pool *, void *page);
+static void release_range (struct pool *, size_t page_idx, size_t page_cnt);
 
 /* multiboot info */
 struct multiboot_info {
@@ -223,12 +252,12 @@ split:
 			page_idx = pg_no (start) - pg_no (pool->base);
 			if ((uint64_t) pool_end < end) {
 				page_cnt = ((uint64_t) pool_end - start) / PGSIZE;
-				bitmap_set_multiple (pool->used_map, page_idx, page_cnt, false);
+				release_range (pool, page_idx, page_cnt);
 				start = (uint64_t) pool_end;
 				goto split;
 			} else {
 				page_cnt = ((uint64_t) end - start) / PGSIZE;
-				bitmap_set_multiple (pool->used_map, page_idx, page_cnt, false);
+				release_range (pool, page_idx, page_cnt);
 			}
 		}
 	}
@@ -253,20 +282,135 @@ palloc_init (void) {
 	return ext_mem.end;
 }
 
+/* Returns the smallest order whose blocks hold PAGE_CNT pages. */
+static unsigned
+cnt_to_order (size_t page_cnt) {
+	unsigned order = 0;
+
+	while (((size_t) 1 << order) < page_cnt)
+		order++;
+	return order;
+}
+
+/* Returns the largest order of a block that starts at PAGE_IDX
+   and fits in PAGE_CNT pages. */
+static unsigned
+max_block_order (size_t page_idx, size_t page_cnt) {
+	unsigned order = 0;
+
+	while (order + 1 < BUDDY_ORDERS
+			&& page_idx % ((size_t) 2 << order) == 0
+			&& ((size_t) 2 << order) <= page_cnt)
+		order++;
+	return order;
+}
+
+/* Adds the free block of 2**ORDER pages at PAGE_IDX to POOL,
+   merging it with its buddy as long as the buddy is free too.
+   POOL's lock must be held. */
+static void
+buddy_free (struct pool *pool, size_t page_idx, unsigned order) {
+	size_t pool_pages = bitmap_size (pool->used_map);
+
+	while (order + 1 < BUDDY_ORDERS) {
+		size_t buddy_idx = page_idx ^ ((size_t) 1 << order);
+
+		if (buddy_idx + ((size_t) 1 << order) > pool_pages
+				|| pool->free_order[buddy_idx] != order + 1)
+			break;
+
+		list_remove (&pool->free_elem[buddy_idx]);
+		pool->free_order[buddy_idx] = 0;
+		if (buddy_idx < page_idx)
+			page_idx = buddy_idx;
+		order++;
+	}
+
+	pool->free_order[page_idx] = order + 1;
+	list_push_front (&pool->free_list[order], &pool->free_elem[page_idx]);
+}
+
+/* Removes a block of 2**ORDER pages from POOL and returns the
+   index of its first page, or BITMAP_ERROR if there is no such
+   block.  A larger block is split if needed.  POOL's lock must be
+   held. */
+static size_t
+buddy_alloc (struct pool *pool, unsigned order) {
+	unsigned k;
+	size_t page_idx;
+
+	for (k = order; k < BUDDY_ORDERS; k++)
+		if (!list_empty (&pool->free_list[k]))
+			break;
+	if (k == BUDDY_ORDERS)
+		return BITMAP_ERROR;
+
+	page_idx = list_pop_front (&pool->free_list[k]) - pool->free_elem;
+	pool->free_order[page_idx] = 0;
+
+	/* Give back the upper halves until the block has the
+	   requested order. */
+	while (k > order) {
+		size_t half_idx;
+
+		k--;
+		half_idx = page_idx + ((size_t) 1 << k);
+		pool->free_order[half_idx] = k + 1;
+		list_push_front (&pool->free_list[k], &pool->free_elem[half_idx]);
+	}
+	return page_idx;
+}
+
+/* Adds the PAGE_CNT pages starting at PAGE_IDX to POOL's free
+   blocks, as the largest aligned blocks that fit.  POOL's lock
+   must be held, or the pool not yet in use. */
+static void
+buddy_free_range (struct pool *pool, size_t page_idx, size_t page_cnt) {
+	while (page_cnt > 0) {
+		unsigned order = max_block_order (page_idx, page_cnt);
+
+		buddy_free (pool, page_idx, order);
+		page_idx += (size_t) 1 << order;
+		page_cnt -= (size_t) 1 << order;
+	}
+}
+
+/* Marks the PAGE_CNT pages starting at PAGE_IDX of POOL usable
+   and free, while populating the pools. */
+static void
+release_range (struct pool *pool, size_t page_idx, size_t page_cnt) {
+	bitmap_set_multiple (pool->used_map, page_idx, page_cnt, false);
+	buddy_free_range (pool, page_idx, page_cnt);
+}
+
 /* Obtains and returns a group of PAGE_CNT contiguous free pages.
    If PAL_USER is set, the pages are obtained from the user pool,
    otherwise from the kernel pool.  If PAL_ZERO is set in FLAGS,
    then the pages are filled with zeros.  If too few pages are
    available, returns a null pointer, unless PAL_ASSERT is set in
    FLAGS, in which case the kernel panics. */
-void *
-palloc_get_multiple (enum palloc_flags flags, size_t page_cnt) {
+static void *
+get_pages (enum palloc_flags flags, size_t page_cnt) {
 	struct pool *pool = flags & PAL_USER ? &user_pool : &kernel_pool;
+	unsigned order = cnt_to_order (page_cnt);
+	size_t page_idx = BITMAP_ERROR;
+	void *pages;
 
-	lock_acquire (&pool->lock);
+	/* ------------ before buddy allocator ------------
 	size_t page_idx = bitmap_scan_and_flip (pool->used_map, 0, page_cnt, false);
+	*/
+
+	lock_acquire (&pool->lock);
+	if (page_cnt > 0 && order < BUDDY_ORDERS)
+		page_idx = buddy_alloc (pool, order);
+	if (page_idx != BITMAP_ERROR) {
+		/* Give back the pages beyond PAGE_CNT. */
+		buddy_free_range (pool, page_idx + page_cnt,
+				((size_t) 1 << order) - page_cnt);
+		ASSERT (bitmap_none (pool->used_map, page_idx, page_cnt));
+		bitmap_set_multiple (pool->used_map, page_idx, page_cnt, true);
+	}
 	lock_release (&pool->lock);
-	void *pages;
 
 	if (page_idx != BITMAP_ERROR)
 		pages = pool->base + PGSIZE * page_idx;
@@ -284,6 +428,19 @@ palloc_get_multiple (enum palloc_flags flags, size_t page_cnt) {
 	return pages;
 }
 
+/* Obtains and returns a group of PAGE_CNT contiguous free pages.
+   See get_pages().  Unless PAL_NOPROF is set in FLAGS, the pages
+   are recorded by the heap profiler. */
+void *
+palloc_get_multiple (enum palloc_flags flags, size_t page_cnt) {
+	void *pages = get_pages (flags, page_cnt);
+
+	if (!(flags & PAL_NOPROF))
+		heapprof_alloc (HEAPPROF_PALLOC, pages, PGSIZE * page_cnt,
+				__builtin_return_address (0));
+	return pages;
+}
+
 /* Obtains a single free page and returns its kernel virtual
    address.
    If PAL_USER is set, the page is obtained from the user pool,
@@ -293,7 +450,12 @@ palloc_get_multiple (enum palloc_flags flags, size_t page_cnt) {
    FLAGS, in which case the kernel panics. */
 void *
 palloc_get_page (enum palloc_flags flags) {
-	return palloc_get_multiple (flags, 1);
+	void *page = get_pages (flags, 1);
+
+	if (!(flags & PAL_NOPROF))
+		heapprof_alloc (HEAPPROF_PALLOC, page, PGSIZE,
+				__builtin_return_address (0));
+	return page;
 }
 
 /* Frees the PAGE_CNT pages starting at PAGES. */
@@ -314,12 +476,16 @@ palloc_free_multiple (void *pages, size_t page_cnt) {
 		NOT_REACHED ();
 
 	page_idx = pg_no (pages) - pg_no (pool->base);
+	heapprof_free (pages);
 
 #ifndef NDEBUG
 	memset (pages, 0xcc, PGSIZE * page_cnt);
 #endif
+	lock_acquire (&pool->lock);
 	ASSERT (bitmap_all (pool->used_map, page_idx, page_cnt));
 	bitmap_set_multiple (pool->used_map, page_idx, page_cnt, false);
+	buddy_free_range (pool, page_idx, page_cnt);
+	lock_release (&pool->lock);
 }
 
 /* Frees the page at PAGE. */
@@ -336,6 +502,10 @@ init_pool (struct pool *p, void **bm_base, uint64_t start, uint64_t end) {
      and subtract it from the pool's size. */
 	uint64_t pgcnt = (end - start) / PGSIZE;
 	size_t bm_pages = DIV_ROUND_UP (bitmap_buf_size (pgcnt), PGSIZE) * PGSIZE;
+	size_t order_pages = DIV_ROUND_UP (pgcnt, PGSIZE) * PGSIZE;
+	size_t elem_pages = DIV_ROUND_UP (pgcnt * sizeof (struct list_elem),
+			PGSIZE) * PGSIZE;
+	unsigned order;
 
 	lock_init(&p->lock);
 	p->used_map = bitmap_create_in_buf (pgcnt, *bm_base, bm_pages);
@@ -345,6 +515,17 @@ init_pool (struct pool *p, void **bm_base, uint64_t start, uint64_t end) {
 	bitmap_set_all(p->used_map, true);
 
 	*bm_base += bm_pages;
+
+	/* No free blocks until populate_pools() releases the usable
+	   pages. */
+	p->free_order = *bm_base;
+	memset (p->free_order, 0, pgcnt);
+	for (order = 0; order < BUDDY_ORDERS; order++)
+		list_init (&p->free_list[order]);
+
+	*bm_base += order_pages;
+	p->free_elem = *bm_base;
+	*bm_base += elem_pages;
 }
 
 /* Returns true if PAGE was allocated from POOL,
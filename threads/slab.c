@@ -0,0 +1,324 @@
+#include "threads/slab.h"
+#include <debug.h>
+#include <list.h>
+#include <round.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "threads/heapprof.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+
+/* A slab allocator, after Bonwick, "The Slab Allocator: An
+   Object-Caching Kernel Memory Allocator" (1994).
+
+   Each cache owns a set of slabs.  A slab is a single page that
+   starts with a struct slab header, followed by a stack of the
+   indexes of its free objects, followed by the objects
+   themselves.  Because a slab is exactly one page, the slab of
+   any object is found by rounding its address down to a page
+   boundary.
+
+   Slabs are kept on one of three lists: full (no free objects),
+   partial, and empty (no objects in use).  Allocation prefers
+   partial slabs, so that empty ones can be given back to the
+   page allocator.  A few empty slabs are kept around so that a
+   cache that repeatedly frees and allocates its last object does
+   not hit the page allocator every time; kmem_cache_shrink()
+   releases them all. */
+
+/* Magic number for detecting slab corruption. */
+#define SLAB_MAGIC 0x51ab51ab
+
+/* Empty slabs a cache keeps before giving pages back. */
+#define SLAB_EMPTY_MAX 2
+
+/* Object cache. */
+struct kmem_cache {
+	const char *name;           /* Name, for statistics. */
+	size_t obj_size;            /* Requested object size. */
+	size_t slot_size;           /* obj_size rounded up to alignment. */
+	size_t objs_per_slab;       /* Number of objects in a slab. */
+	size_t first_ofs;           /* Offset of first object in a slab. */
+	kmem_ctor_func *ctor;       /* Constructor, or null. */
+
+	struct lock lock;           /* Protects the fields below. */
+	struct list partial;        /* Slabs with used and free objects. */
+	struct list full;           /* Slabs with no free objects. */
+	struct list empty;          /* Slabs with no used objects. */
+	size_t slab_cnt;            /* Number of slabs. */
+	size_t empty_cnt;           /* Number of slabs in `empty'. */
+	size_t in_use;              /* Number of allocated objects. */
+
+	struct list_elem elem;      /* Element in `caches'. */
+};
+
+/* Slab header, at the start of each slab's page. */
+struct slab {
+	unsigned magic;             /* Always set to SLAB_MAGIC. */
+	struct kmem_cache *cache;   /* Owning cache. */
+	struct list_elem elem;      /* Element in one of the cache's lists. */
+	size_t free_cnt;            /* Number of free objects. */
+	uint16_t free[];            /* Indexes of free objects, a stack. */
+};
+
+/* All caches, for statistics. */
+static struct list caches;
+static struct lock caches_lock;
+
+/* Initializes the slab allocator. */
+void
+slab_init (void) {
+	list_init (&caches);
+	lock_init (&caches_lock);
+}
+
+/* Returns the offset of the first object in a slab holding CNT
+   objects aligned to ALIGN. */
+static size_t
+first_obj_ofs (size_t cnt, size_t align) {
+	return ROUND_UP (sizeof (struct slab) + cnt * sizeof (uint16_t), align);
+}
+
+/* Creates and returns a cache of objects SIZE bytes long,
+   aligned to ALIGN bytes (a power of 2, or 0 for the natural
+   alignment of a pointer).  CTOR, if non-null, is called on each
+   object when its slab is created.  NAME is used in statistics.
+   Returns a null pointer if memory is not available.
+
+   Objects must be small enough that several fit in a page; use
+   malloc() or palloc_get_page() for larger ones. */
+struct kmem_cache *
+kmem_cache_create (const char *name, size_t size, size_t align,
+		kmem_ctor_func *ctor) {
+	struct kmem_cache *c;
+	size_t cnt;
+
+	if (align == 0)
+		align = sizeof (void *);
+	ASSERT (name != NULL);
+	ASSERT (size > 0);
+	ASSERT ((align & (align - 1)) == 0);
+
+	c = malloc (sizeof *c);
+	if (c == NULL)
+		return NULL;
+
+	c->name = name;
+	c->obj_size = size;
+	c->slot_size = ROUND_UP (size, align);
+	c->ctor = ctor;
+
+	/* Fit as many objects as possible in a page. */
+	cnt = (PGSIZE - sizeof (struct slab)) / (c->slot_size + sizeof (uint16_t));
+	while (cnt > 0 && first_obj_ofs (cnt, align) + cnt * c->slot_size > PGSIZE)
+		cnt--;
+	ASSERT (cnt >= 2);
+	c->objs_per_slab = cnt;
+	c->first_ofs = first_obj_ofs (cnt, align);
+
+	lock_init (&c->lock);
+	list_init (&c->partial);
+	list_init (&c->full);
+	list_init (&c->empty);
+	c->slab_cnt = c->empty_cnt = c->in_use = 0;
+
+	lock_acquire (&caches_lock);
+	list_push_back (&caches, &c->elem);
+	lock_release (&caches_lock);
+
+	return c;
+}
+
+/* Returns the IDX'th object in slab S. */
+static void *
+slab_obj (struct slab *s, size_t idx) {
+	ASSERT (idx < s->cache->objs_per_slab);
+	return (uint8_t *) s + s->cache->first_ofs + idx * s->cache->slot_size;
+}
+
+/* Returns the slab that OBJ, an object of cache C, is in. */
+static struct slab *
+obj_to_slab (struct kmem_cache *c, void *obj) {
+	struct slab *s = pg_round_down (obj);
+
+	ASSERT (s->magic == SLAB_MAGIC);
+	ASSERT (s->cache == c);
+	ASSERT (pg_ofs (obj) >= c->first_ofs);
+	ASSERT ((pg_ofs (obj) - c->first_ofs) % c->slot_size == 0);
+	return s;
+}
+
+/* Allocates a new slab for cache C and constructs its objects.
+   Returns a null pointer if no page is available. */
+static struct slab *
+slab_create (struct kmem_cache *c) {
+	struct slab *s = palloc_get_page (PAL_NOPROF);
+	size_t i;
+
+	if (s == NULL)
+		return NULL;
+
+	s->magic = SLAB_MAGIC;
+	s->cache = c;
+	s->free_cnt = c->objs_per_slab;
+	for (i = 0; i < c->objs_per_slab; i++) {
+		/* Hand out low addresses first. */
+		s->free[i] = c->objs_per_slab - 1 - i;
+		if (c->ctor != NULL)
+			c->ctor (slab_obj (s, i));
+	}
+	return s;
+}
+
+/* Gives empty slab S of cache C back to the page allocator.
+   C's lock must be held and S must be in C->empty. */
+static void
+slab_destroy (struct kmem_cache *c, struct slab *s) {
+	ASSERT (s->free_cnt == c->objs_per_slab);
+
+	list_remove (&s->elem);
+	c->empty_cnt--;
+	c->slab_cnt--;
+	s->magic = 0;
+	palloc_free_page (s);
+}
+
+/* Allocates and returns an object from cache C, without
+   recording it in the heap profiler.  Returns a null pointer if
+   memory is not available. */
+static void *
+cache_alloc (struct kmem_cache *c) {
+	struct slab *s;
+	void *obj;
+
+	ASSERT (c != NULL);
+
+	lock_acquire (&c->lock);
+
+	/* Prefer a partial slab, then an empty one, then a new one. */
+	if (!list_empty (&c->partial))
+		s = list_entry (list_front (&c->partial), struct slab, elem);
+	else if (!list_empty (&c->empty)) {
+		s = list_entry (list_pop_front (&c->empty), struct slab, elem);
+		c->empty_cnt--;
+		list_push_front (&c->partial, &s->elem);
+	} else {
+		s = slab_create (c);
+		if (s == NULL) {
+			lock_release (&c->lock);
+			return NULL;
+		}
+		c->slab_cnt++;
+		list_push_front (&c->partial, &s->elem);
+	}
+
+	obj = slab_obj (s, s->free[--s->free_cnt]);
+	if (s->free_cnt == 0) {
+		list_remove (&s->elem);
+		list_push_back (&c->full, &s->elem);
+	}
+	c->in_use++;
+
+	lock_release (&c->lock);
+	return obj;
+}
+
+/* Allocates and returns an object from cache C.
+   Returns a null pointer if memory is not available. */
+void *
+kmem_cache_alloc (struct kmem_cache *c) {
+	void *obj = cache_alloc (c);
+
+	heapprof_alloc (HEAPPROF_SLAB, obj, c->obj_size,
+			__builtin_return_address (0));
+	return obj;
+}
+
+/* Allocates an object from cache C and fills it with zeros, like
+   calloc().  Only for caches without a constructor. */
+void *
+kmem_cache_zalloc (struct kmem_cache *c) {
+	void *obj;
+
+	ASSERT (c->ctor == NULL);
+
+	obj = cache_alloc (c);
+	if (obj != NULL)
+		memset (obj, 0, c->obj_size);
+	heapprof_alloc (HEAPPROF_SLAB, obj, c->obj_size,
+			__builtin_return_address (0));
+	return obj;
+}
+
+/* Frees OBJ, which must have been allocated from cache C.  A null
+   OBJ is ignored, like free(). */
+void
+kmem_cache_free (struct kmem_cache *c, void *obj) {
+	struct slab *s;
+
+	ASSERT (c != NULL);
+	if (obj == NULL)
+		return;
+
+	s = obj_to_slab (c, obj);
+	heapprof_free (obj);
+
+	lock_acquire (&c->lock);
+
+	if (s->free_cnt == 0) {
+		list_remove (&s->elem);
+		list_push_front (&c->partial, &s->elem);
+	}
+	s->free[s->free_cnt++] = ((uint8_t *) obj - (uint8_t *) slab_obj (s, 0))
+		/ c->slot_size;
+	c->in_use--;
+
+	if (s->free_cnt == c->objs_per_slab) {
+		list_remove (&s->elem);
+		list_push_front (&c->empty, &s->elem);
+		c->empty_cnt++;
+		if (c->empty_cnt > SLAB_EMPTY_MAX)
+			slab_destroy (c, s);
+	}
+
+	lock_release (&c->lock);
+}
+
+/* Gives all of cache C's empty slabs back to the page allocator.
+   Returns the number of pages freed. */
+size_t
+kmem_cache_shrink (struct kmem_cache *c) {
+	size_t freed = 0;
+
+	ASSERT (c != NULL);
+
+	lock_acquire (&c->lock);
+	while (!list_empty (&c->empty)) {
+		slab_destroy (c, list_entry (list_front (&c->empty), struct slab, elem));
+		freed++;
+	}
+	lock_release (&c->lock);
+
+	return freed;
+}
+
+/* Prints, for every cache, the objects in use and the bytes they
+   requested against the bytes of the slabs holding them. */
+void
+slab_print_stats (void) {
+	struct list_elem *e;
+
+	lock_acquire (&caches_lock);
+	for (e = list_begin (&caches); e != list_end (&caches); e = list_next (e)) {
+		struct kmem_cache *c = list_entry (e, struct kmem_cache, elem);
+
+		printf ("Slab %s: %zu objects of %zu bytes, "
+				"%zu bytes requested, %zu bytes used in %zu slabs\n",
+				c->name, c->in_use, c->obj_size, c->in_use * c->obj_size,
+				c->slab_cnt * PGSIZE, c->slab_cnt);
+	}
+	lock_release (&caches_lock);
+}
@@ -31,26 +31,72 @@
 #include <string.h>
 #include "threads/interrupt.h"
 #include "threads/thread.h"
+#ifdef LOCKSTAT
+#include "devices/timer.h"
+#endif
 
 /* One semaphore in a list. */
 struct semaphore_elem {
   struct list_elem elem;      /* List element. */
   struct semaphore semaphore; /* This semaphore. */
+  struct thread *thread;      /* Waiting thread. */
 };
 
 /* ---------- added for Project.1-2 ---------- */
-static void remove_donor_lock(struct lock *lock) {
-  struct thread *curr_t = thread_current();
-  struct list_elem *donor_e;
 
-  for (donor_e = list_begin(&curr_t->donations);
-       donor_e != list_end(&curr_t->donations); donor_e = list_next(donor_e)) {
-    struct thread *t = list_entry(donor_e, struct thread, donation_elem);
+/* ---------- after O(log n) donation ----------
+   기부자(donations list)를 holder에 모아두고 lock_release()마다 전부 순회하던
+   방식 대신 lock마다 대기중인 thread들의 priority max-heap(lock->waiters)을
+   둔다. holder의 priority는 자신이 가진 lock들의 heap top 중 최대값이다. */
+
+/* 같은 priority의 waiter를 FIFO로 깨우기 위한 순번 */
+static unsigned lock_wait_seq;
+
+/* lock을 가진 thread를 반환한다. (lock->owner에서 LOCK_CONTENDED를 뺀다) */
+static void lock_acquire_slow(struct lock *lock);
+static void lock_release_slow(struct lock *lock);
+
+static inline struct thread *lock_owner(const struct lock *lock) {
+  uintptr_t owner = __atomic_load_n(&lock->owner, __ATOMIC_ACQUIRE);
+
+  return (struct thread *)(owner & ~LOCK_CONTENDED);
+}
+
+/**
+ * @brief lock->waiters heap의 정렬 기준.
+ *        priority가 같다면 먼저 기다린 thread가 크다.
+*/
+static bool cmp_lock_waiter(const struct heap_elem *a,
+                            const struct heap_elem *b, void *aux UNUSED) {
+  struct thread *a_t = heap_entry(a, struct thread, lock_elem);
+  struct thread *b_t = heap_entry(b, struct thread, lock_elem);
 
-    if (t->wait_on_lock == NULL) break;
+  if (a_t->priority != b_t->priority) return a_t->priority < b_t->priority;
+  return (int)(a_t->lock_wait_seq - b_t->lock_wait_seq) > 0;
+}
 
-    if (t->wait_on_lock == lock) list_remove(&(t->donation_elem));
+/**
+ * @brief t가 기부받은 priority를 포함한 priority를 계산한다.
+ * 
+ * @return t->initial_priority와 t가 가진 lock들의 waiters heap top의
+ *         priority 중 최대값. O(t가 가진 lock의 개수)
+*/
+static int thread_donated_priority(struct thread *t) {
+  int priority = t->initial_priority;
+  struct list_elem *e;
+
+  for (e = list_begin(&t->held_locks); e != list_end(&t->held_locks);
+       e = list_next(e)) {
+    struct lock *lock = list_entry(e, struct lock, held_elem);
+    struct heap_elem *top = heap_top(&lock->waiters);
+
+    if (top == NULL) continue;
+
+    int donor_priority = heap_entry(top, struct thread, lock_elem)->priority;
+    if (priority < donor_priority) priority = donor_priority;
   }
+
+  return priority;
 }
 
 /**
@@ -58,8 +104,12 @@ static void remove_donor_lock(struct lock *lock) {
  *        priority를 lock->holder에게 상속한다
  * 
  * @details [case.1] : nested
+ *          holder도 다른 lock을 기다리고 있다면 그 lock의 waiters heap에서
+ *          holder의 위치를 올리고(heap_increase_key, O(1)) 다음 holder로
+ *          넘어간다.
  *          
  *          [case.2] : multiple
+ *          holder가 여러 lock을 가지고 있어도 각 lock의 heap top만 보면 된다.
 */
 static void donate_priority(void) {
   struct thread *curr_t = thread_current();
@@ -67,64 +117,59 @@ static void donate_priority(void) {
   int depth = 0;
 
   while (depth < 8) {
+    struct thread *holder;
 
     if (curr_t->wait_on_lock == NULL) break;
 
-    curr_t = curr_t->wait_on_lock->holder;
+    holder = lock_owner(curr_t->wait_on_lock);
 
-    /* TODO
-			 정렬된 순서대로 들어가기에 비교를 할 필요가 없다는데
-			 아무리봐도 아닌거같은데 생각해보자... */
-    if (curr_t->priority < prev_priority) {
-      curr_t->priority = prev_priority;
-      prev_priority = curr_t->priority;
-    }
+    /* holder가 이미 더 높다면 그 위의 holder들도 그렇다. */
+    if (holder == NULL || holder->priority >= prev_priority) break;
 
+    /* holder가 READY 상태일 수 있으므로 ready queue도 함께 갱신한다. */
+    thread_update_priority(holder, prev_priority);
+    if (holder->wait_on_lock != NULL)
+      heap_increase_key(&holder->wait_on_lock->waiters, &holder->lock_elem);
+
+    curr_t = holder;
     depth++;
   }
 }
+
 /**
  * @brief lock->holder가 특정 lock에 대해 lock_release() 했을때
  *        상속받은 priority를 원래 priority로 되돌리거나
  *        다른 wait_on_lock의 thread->priority를 상속받는다
+ * 
+ * @details 남아있는 lock들의 heap top만 비교한다. (thread_donated_priority)
 */
 void update_priority_donation(void) {
   struct thread *curr_t = thread_current();
-  struct list_elem *higher_e;
-  struct thread *higher_t;
-
-  curr_t->priority = curr_t->initial_priority;
-
-  if (list_empty(&curr_t->donations)) return;
 
-  higher_e = list_max(&curr_t->donations, &cmp_ascending_priority, NULL);
-  higher_t = list_entry(higher_e, struct thread, donation_elem);
-  // printf("\n-------------------------\n");
-  // printf("higher_t->priority : %d\n", higher_t->priority);
-  // printf("curr_t->priority : %d\n", curr_t->priority);
-  // printf("\n-------------------------\n");
-  // if (higher_t == list_begin(&curr_t->donations))
-
-  if (curr_t->priority < higher_t->priority) {
-    curr_t->priority = higher_t->priority;
-  }
+  curr_t->priority = thread_donated_priority(curr_t);
 }
 
 static bool cmp_cond_ascending_priority(const struct list_elem *a,
                                         const struct list_elem *b,
                                         void *aux UNUSED) {
   struct semaphore_elem *sema_a, *sema_b;
-  struct list_elem *e_a, *e_b;
   struct thread *t_a, *t_b;
 
   sema_a = list_entry(a, struct semaphore_elem, elem);
   sema_b = list_entry(b, struct semaphore_elem, elem);
 
+  /* ------- before reader-writer lock -------
+     cond_wait()은 lock을 놓은 뒤에 sema_down()하므로 그 사이에는
+     semaphore.waiters가 비어있을 수 있다.
+
   e_a = list_begin(&sema_a->semaphore.waiters);
   e_b = list_begin(&sema_b->semaphore.waiters);
 
   t_a = list_entry(e_a, struct thread, elem);
-  t_b = list_entry(e_b, struct thread, elem);
+  t_b = list_entry(e_b, struct thread, elem); */
+
+  t_a = sema_a->thread;
+  t_b = sema_b->thread;
 
   return (t_a->priority) > (t_b->priority);
 }
@@ -281,6 +326,17 @@ void sema_up(struct semaphore *sema) {
   old_level = intr_disable();
 
   if (!list_empty(&sema->waiters)) {
+    /* --------- added for incremental mlfqs ---------
+       BLOCKED thread의 priority는 깨어날때 갱신되므로 누구를 깨울지
+       고르기 전에 waiters의 priority를 최신으로 만든다. */
+    if (thread_mlfqs) {
+      struct list_elem *e;
+
+      for (e = list_begin(&sema->waiters); e != list_end(&sema->waiters);
+           e = list_next(e))
+        thread_refresh_mlfqs(list_entry(e, struct thread, elem));
+    }
+
     /* --------- after Project.1-2 --------- */
     list_sort(&sema->waiters, (list_less_func *)&cmp_ascending_priority, NULL);
 
@@ -291,6 +347,12 @@ void sema_up(struct semaphore *sema) {
 
   sema->value++;
   intr_set_level(old_level);
+
+  /* 깨운 thread의 priority가 더 높다면 양보한다. (O(log n) donation)
+     e.g. priority-donate-sema : 기부받은 L이 바로 실행되어야 한다.
+     일부러 interrupt를 끄고 부른 호출자(e.g. 종료 경로)는 그 안에서
+     양보하지 않도록 interrupt가 켜져 있었을때만 양보한다. */
+  if (old_level == INTR_ON && !intr_context()) check_preempt();
 }
 
 static void sema_test_helper(void *sema_);
@@ -370,11 +432,146 @@ static void sema_test_helper(void *sema_) {
  *       >  이러한 제한이 부담스럽다고 판명되면 세마포어 대신 잠금을 사용해야 한다는
  *       >  좋은 신호입니다.
 */
-void lock_init(struct lock *lock) {
+void(lock_init)(struct lock *lock) {
   ASSERT(lock != NULL);
 
+  lock->owner = 0;
   lock->holder = NULL;
-  sema_init(&lock->semaphore, 1);
+  heap_init(&lock->waiters, cmp_lock_waiter, NULL);
+#ifdef LOCKSTAT
+  lock->stat = NULL;
+#endif
+}
+
+/* ------------ added for lock statistics ------------ */
+
+#ifdef LOCKSTAT
+/* 등록된 모든 struct lock_stat. thread_init()이 처음 lock_init()을 부르기
+   전에 lockstat_init()으로 초기화한다. */
+static struct list lock_stats;
+
+/* -lockstat: lock 통계를 종료할때 출력할까? */
+bool lockstat;
+
+/* lock_stats를 초기화한다. 어떤 lock_init()보다도 먼저 불려야 한다. */
+void lockstat_init(void) {
+  list_init(&lock_stats);
+}
+
+/**
+ * @brief lock을 초기화하고 lock_init()을 호출한 위치의 통계 STAT에 묶는다.
+ * 
+ * @note lock_init() macro가 호출한다. 직접 부를 필요는 없다.
+*/
+void lock_init_stat(struct lock *lock, struct lock_stat *stat) {
+  enum intr_level old_level;
+
+  (lock_init)(lock);
+  lock->stat = stat;
+
+  old_level = intr_disable();
+  if (!stat->registered) {
+    stat->registered = true;
+    list_push_back(&lock_stats, &stat->elem);
+  }
+  intr_set_level(old_level);
+}
+
+/* *MAX를 VALUE로 키운다. */
+static void lock_stat_max(int64_t *max, int64_t value) {
+  int64_t old = __atomic_load_n(max, __ATOMIC_RELAXED);
+
+  while (value > old &&
+         !__atomic_compare_exchange_n(max, &old, value, false,
+                                      __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+    continue;
+}
+
+/**
+ * @brief lock을 얻었음을 기록한다.
+ * 
+ * @param contended fast path로 바로 얻지 못하고 기다렸다면 true
+ * @param wait 기다린 ticks
+ * 
+ * @details 같은 lock_stat을 쓰는 다른 lock은 동시에 잡혀 있을 수 있으므로
+ *          counter는 atomic하게 더한다.
+*/
+static void lock_stat_acquired(struct lock *lock, bool contended,
+                               int64_t wait) {
+  struct lock_stat *stat = lock->stat;
+
+  lock->acquired_tick = timer_ticks();
+  if (stat == NULL) return;
+
+  __atomic_fetch_add(&stat->acquires, 1, __ATOMIC_RELAXED);
+  if (contended) {
+    __atomic_fetch_add(&stat->contended, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&stat->wait_ticks, wait, __ATOMIC_RELAXED);
+    lock_stat_max(&stat->max_wait_ticks, wait);
+  }
+}
+
+/* lock을 놓기 직전에 얼마나 오래 가지고 있었는지 기록한다. */
+static void lock_stat_released(struct lock *lock) {
+  struct lock_stat *stat = lock->stat;
+  int64_t hold;
+
+  if (stat == NULL) return;
+
+  hold = timer_ticks() - lock->acquired_tick;
+  __atomic_fetch_add(&stat->hold_ticks, hold, __ATOMIC_RELAXED);
+  lock_stat_max(&stat->max_hold_ticks, hold);
+}
+
+/* 기다린 횟수가 많은 순서로 정렬하기 위한 비교 함수 */
+static bool cmp_lock_stat_contended(const struct list_elem *a,
+                                    const struct list_elem *b,
+                                    void *aux UNUSED) {
+  const struct lock_stat *stat_a = list_entry(a, struct lock_stat, elem);
+  const struct lock_stat *stat_b = list_entry(b, struct lock_stat, elem);
+
+  if (stat_a->contended != stat_b->contended)
+    return stat_a->contended > stat_b->contended;
+  return stat_a->acquires > stat_b->acquires;
+}
+
+/**
+ * @brief 한번이라도 잡혔던 lock들의 통계를 기다린 횟수가 많은 순서로
+ *        출력한다. -lockstat을 줬을때만 출력한다.
+*/
+void lock_print_stats(void) {
+  enum intr_level old_level;
+
+  if (!lockstat || list_empty(&lock_stats)) return;
+
+  old_level = intr_disable();
+  list_sort(&lock_stats, cmp_lock_stat_contended, NULL);
+  intr_set_level(old_level);
+
+  printf("Locks: acquires contended wait(total/max) hold(total/max) ticks\n");
+  for (struct list_elem *e = list_begin(&lock_stats);
+       e != list_end(&lock_stats); e = list_next(e)) {
+    struct lock_stat *stat = list_entry(e, struct lock_stat, elem);
+
+    if (stat->acquires == 0) continue;
+    printf("  %s (%s): %llu %llu %lld/%lld %lld/%lld\n", stat->name,
+           stat->where, stat->acquires, stat->contended, stat->wait_ticks,
+           stat->max_wait_ticks, stat->hold_ticks, stat->max_hold_ticks);
+  }
+}
+#endif
+
+/* ---------- added for lock fast path ---------- */
+
+/**
+ * @brief lock->owner가 expected라면 desired로 바꾼다. (compare-and-swap)
+ * 
+ * @return 바꿨다면 true
+*/
+static inline bool lock_cas(struct lock *lock, uintptr_t expected,
+                            uintptr_t desired) {
+  return __atomic_compare_exchange_n(&lock->owner, &expected, desired, false,
+                                     __ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
 }
 
 /* Acquires LOCK, sleeping until it becomes available if
@@ -411,27 +608,83 @@ void lock_acquire(struct lock *lock) {
 
   struct thread *cur_t = thread_current();
 
-  /* ----------- after Project.1-2 ----------- */
+  /* ---------- added for lock fast path ----------
+     아무도 없다면 CAS 한번으로 lock을 얻는다. interrupt도 끄지 않고
+     held_locks에도 넣지 않는다. (기부할 waiter가 생길때 넣는다) */
+  if (lock_cas(lock, 0, (uintptr_t)cur_t)) {
+    lock->holder = cur_t;
+#ifdef LOCKSTAT
+    lock_stat_acquired(lock, false, 0);
+#endif
+    return;
+  }
 
-  if (lock->holder != NULL) {
-    cur_t->wait_on_lock = lock;
-    list_push_back(&(lock->holder->donations), &(cur_t->donation_elem));
+#ifdef LOCKSTAT
+  int64_t wait_start = timer_ticks();
+#endif
 
-    /* ---------- added for Project.1-2 ---------- */
+  /* holder가 다른 CPU에서 RUNNING일때만 spin할 가치가 있다. CPU가 하나라면
+     holder는 우리가 도는 동안 절대 실행되지 않으므로 spin하지 않고 바로
+     slow path로 가서 block 한다. (slow path는 그 사이 lock이 풀렸다면
+     다시 CAS로 얻는다) */
+  lock_acquire_slow(lock);
 
-    // donate_priority();
+#ifdef LOCKSTAT
+  lock_stat_acquired(lock, true, timer_ticks() - wait_start);
+#endif
+}
+
+/**
+ * @brief 다른 thread가 가진 lock을 기다린다. (slow path)
+ * 
+ * @details waiters heap에 들어가 holder에게 priority를 기부하고 block
+ *          한다. lock_release()가 lock을 넘겨준 뒤(hand-off) 깨워준다.
+ * 
+ *          처음으로 기다리는 thread는 lock->owner에 LOCK_CONTENDED를 켜
+ *          holder가 fast path로 lock을 풀지 못하게 하고, holder가 기부를
+ *          받도록 lock을 holder->held_locks에 넣는다.
+*/
+static void lock_acquire_slow(struct lock *lock) {
+  struct thread *cur_t = thread_current();
+  enum intr_level old_level;
+
+  old_level = intr_disable();
+
+  for (;;) {
+    uintptr_t owner = __atomic_load_n(&lock->owner, __ATOMIC_ACQUIRE);
+    struct thread *holder = (struct thread *)(owner & ~LOCK_CONTENDED);
+
+    /* 그 사이에 풀렸다. */
+    if (holder == NULL) {
+      if (lock_cas(lock, 0, (uintptr_t)cur_t)) break;
+      continue;
+    }
+
+    if (!(owner & LOCK_CONTENDED)) {
+      /* holder가 그 사이에 fast path로 풀었다면 다시 시도한다. */
+      if (!lock_cas(lock, owner, owner | LOCK_CONTENDED)) continue;
+      list_push_back(&holder->held_locks, &lock->held_elem);
+    }
+
+    /* --------- after O(log n) donation --------- */
+
+    cur_t->wait_on_lock = lock;
+    cur_t->lock_wait_seq = lock_wait_seq++;
+    heap_push(&lock->waiters, &cur_t->lock_elem);
 
     /* ---------- added for Project.1-3 ---------- */
 
     if (!thread_mlfqs) donate_priority();
 
     /* ------------------------------------------- */
-  }
 
-  sema_down(&lock->semaphore);
+    thread_block();
+    ASSERT(lock_owner(lock) == cur_t);
+    break;
+  }
 
   lock->holder = cur_t; /* lock을 가진다 */
-  cur_t->wait_on_lock = NULL; /* lock을 얻었으므로 대기중인 lock은 없다 */
+  intr_set_level(old_level);
 }
 
 /* Tries to acquires LOCK and returns true if successful or false
@@ -441,13 +694,19 @@ void lock_acquire(struct lock *lock) {
    This function will not sleep, so it may be called within an
    interrupt handler. */
 bool lock_try_acquire(struct lock *lock) {
+  struct thread *cur_t = thread_current();
   bool success;
 
   ASSERT(lock != NULL);
   ASSERT(!lock_held_by_current_thread(lock));
 
-  success = sema_try_down(&lock->semaphore);
-  if (success) lock->holder = thread_current();
+  success = lock_cas(lock, 0, (uintptr_t)cur_t);
+  if (success) {
+    lock->holder = cur_t;
+#ifdef LOCKSTAT
+    lock_stat_acquired(lock, false, 0);
+#endif
+  }
   return success;
 }
 
@@ -457,24 +716,77 @@ bool lock_try_acquire(struct lock *lock) {
    An interrupt handler cannot acquire a lock, so it does not
    make sense to try to release a lock within an interrupt
    handler. */
+/**
+ * @brief lock을 놓는다.
+ * 
+ * @details 기다리는 thread가 없다면(LOCK_CONTENDED가 꺼져있다면) CAS
+ *          한번으로 푼다. 기부받은 priority도 없으므로 되돌릴 것이 없다.
+ *          CAS가 실패했다면 waiter가 있다는 뜻이므로 slow path로 넘겨준다.
+*/
 void lock_release(struct lock *lock) {
+  uintptr_t cur_t = (uintptr_t)thread_current();
+
   ASSERT(lock != NULL);
   ASSERT(lock_held_by_current_thread(lock));
 
-  remove_donor_lock(lock);
+#ifdef LOCKSTAT
+  lock_stat_released(lock);
+#endif
 
-  /* ---------- added for Project.1-2 ---------- */
+  lock->holder = NULL;
 
-  // update_priority_donation();
+  /* ---------- added for lock fast path ---------- */
+
+  if (__atomic_compare_exchange_n(&lock->owner, &cur_t, 0, false,
+                                  __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+    return;
+
+  lock_release_slow(lock);
+}
+
+/**
+ * @brief lock을 가장 높은 priority의 waiter에게 넘겨준다. (slow path)
+ * 
+ * @details waiters heap에서 top을 꺼내(O(log n)) 바로 holder로 만들고
+ *          깨운다. 깨어난 thread는 남은 waiters의 기부를 받으며, 현재
+ *          thread는 남은 lock들의 heap top으로 priority를 다시 계산한다.
+ *          더 높은 priority의 thread를 깨웠다면 양보한다.
+*/
+static void lock_release_slow(struct lock *lock) {
+  struct thread *next_t;
+  uintptr_t owner;
+  enum intr_level old_level;
+
+  old_level = intr_disable();
+
+  list_remove(&lock->held_elem);
 
   /* ---------- added for Project.1-3 ---------- */
 
   if (!thread_mlfqs) update_priority_donation();
 
-  /* ------------------------------------------- */
+  /* --------- after O(log n) donation --------- */
 
-  lock->holder = NULL;
-  sema_up(&lock->semaphore);
+  /* LOCK_CONTENDED가 켜져 있었으므로 waiter가 있다. */
+  next_t = heap_entry(heap_pop(&lock->waiters), struct thread, lock_elem);
+  next_t->wait_on_lock = NULL;
+
+  owner = (uintptr_t)next_t;
+  if (!heap_empty(&lock->waiters)) {
+    owner |= LOCK_CONTENDED;
+    list_push_back(&next_t->held_locks, &lock->held_elem);
+  }
+  lock->holder = next_t;
+  __atomic_store_n(&lock->owner, owner, __ATOMIC_RELEASE);
+
+  if (!thread_mlfqs)
+    thread_update_priority(next_t, thread_donated_priority(next_t));
+
+  thread_unblock(next_t);
+
+  intr_set_level(old_level);
+
+  check_preempt();
 }
 
 /**
@@ -491,7 +803,7 @@ void lock_release(struct lock *lock) {
 bool lock_held_by_current_thread(const struct lock *lock) {
   ASSERT(lock != NULL);
 
-  return lock->holder == thread_current();
+  return lock_owner(lock) == thread_current();
 }
 
 /* Initializes condition variable COND.  A condition variable
@@ -532,6 +844,7 @@ void cond_wait(struct condition *cond, struct lock *lock) {
   ASSERT(lock_held_by_current_thread(lock));
 
   sema_init(&waiter.semaphore, 0);
+  waiter.thread = thread_current();
 
   /* ----------- before Project.1-2 -----------
 
@@ -588,3 +901,136 @@ void cond_broadcast(struct condition *cond, struct lock *lock) {
 
   while (!list_empty(&cond->waiters)) cond_signal(cond, lock);
 }
+
+/* ----------- added for reader-writer lock ----------- */
+
+/**
+ * @brief COND에서 기다리는 thread 중 가장 높은 priority를 반환한다.
+ * 
+ * @return 기다리는 thread가 없다면 PRI_MIN - 1
+*/
+static int cond_max_priority(struct condition *cond) {
+  int max = PRI_MIN - 1;
+
+  for (struct list_elem *e = list_begin(&cond->waiters);
+       e != list_end(&cond->waiters); e = list_next(e)) {
+    struct thread *t = list_entry(e, struct semaphore_elem, elem)->thread;
+
+    if (t->priority > max) max = t->priority;
+  }
+
+  return max;
+}
+
+/**
+ * @brief reader-writer lock을 초기화한다.
+ * 
+ * @param rw 초기화할 rwlock
+ * @param prefer_writer true라면 writer가 기다리는 동안 새 reader를 막는다.
+ *                      (reader가 끊이지 않아도 writer가 굶지 않는다)
+*/
+void rwlock_init(struct rwlock *rw, bool prefer_writer) {
+  ASSERT(rw != NULL);
+
+  lock_init(&rw->lock);
+  cond_init(&rw->readers_ok);
+  cond_init(&rw->writers_ok);
+  rw->readers = 0;
+  rw->waiting_writers = 0;
+  rw->writer = NULL;
+  rw->prefer_writer = prefer_writer;
+}
+
+/**
+ * @brief 새 reader가 writer에게 양보해야 하는지 확인한다.
+ * 
+ * @details writer가 쓰고 있거나, writer를 우선하는데 writer가 기다리고
+ *          있거나, 현재 thread보다 priority가 높은 writer가 기다린다면
+ *          양보한다.
+*/
+static bool rwlock_reader_must_wait(struct rwlock *rw) {
+  if (rw->writer != NULL) return true;
+  if (rw->waiting_writers == 0) return false;
+
+  return rw->prefer_writer ||
+         cond_max_priority(&rw->writers_ok) > thread_get_priority();
+}
+
+/**
+ * @brief 읽기 위해 rwlock을 얻는다. 다른 reader와 동시에 가질 수 있다.
+*/
+void rwlock_acquire_read(struct rwlock *rw) {
+  ASSERT(rw != NULL);
+  ASSERT(!intr_context());
+  ASSERT(!rwlock_held_by_current_thread(rw));
+
+  lock_acquire(&rw->lock);
+  while (rwlock_reader_must_wait(rw)) cond_wait(&rw->readers_ok, &rw->lock);
+  rw->readers++;
+  lock_release(&rw->lock);
+}
+
+/**
+ * @brief 읽기 위해 얻은 rwlock을 놓는다.
+ * 
+ * @details 마지막 reader라면 기다리는 writer 중 하나를 깨운다.
+*/
+void rwlock_release_read(struct rwlock *rw) {
+  ASSERT(rw != NULL);
+
+  lock_acquire(&rw->lock);
+  ASSERT(rw->readers > 0);
+  if (--rw->readers == 0) cond_signal(&rw->writers_ok, &rw->lock);
+  lock_release(&rw->lock);
+}
+
+/**
+ * @brief 쓰기 위해 rwlock을 얻는다. reader와 writer 모두 없을때까지
+ *        기다린다.
+*/
+void rwlock_acquire_write(struct rwlock *rw) {
+  ASSERT(rw != NULL);
+  ASSERT(!intr_context());
+  ASSERT(!rwlock_held_by_current_thread(rw));
+
+  lock_acquire(&rw->lock);
+  rw->waiting_writers++;
+  while (rw->writer != NULL || rw->readers > 0)
+    cond_wait(&rw->writers_ok, &rw->lock);
+  rw->waiting_writers--;
+  rw->writer = thread_current();
+  lock_release(&rw->lock);
+}
+
+/**
+ * @brief 쓰기 위해 얻은 rwlock을 놓는다.
+ * 
+ * @details 기다리는 writer와 reader 중 priority가 높은 쪽을 깨운다.
+ *          reader를 깨울때는 모두 깨운다. (동시에 읽을 수 있으므로)
+ *          prefer_writer라면 기다리는 writer를 항상 먼저 깨운다.
+*/
+void rwlock_release_write(struct rwlock *rw) {
+  ASSERT(rw != NULL);
+  ASSERT(rwlock_held_by_current_thread(rw));
+
+  lock_acquire(&rw->lock);
+  rw->writer = NULL;
+  if (rw->waiting_writers > 0 &&
+      (rw->prefer_writer || cond_max_priority(&rw->writers_ok) >
+                                cond_max_priority(&rw->readers_ok)))
+    cond_signal(&rw->writers_ok, &rw->lock);
+  else
+    cond_broadcast(&rw->readers_ok, &rw->lock);
+  lock_release(&rw->lock);
+}
+
+/**
+ * @brief 현재 thread가 쓰기 위해 rwlock을 가지고 있는지 확인한다.
+ * 
+ * @note reader는 누가 가지고 있는지 기록하지 않으므로 알 수 없다.
+*/
+bool rwlock_held_by_current_thread(const struct rwlock *rw) {
+  ASSERT(rw != NULL);
+
+  return rw->writer == thread_current();
+}
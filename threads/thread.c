@@ -6,11 +6,13 @@
 #include <string.h>
 #include "intrinsic.h"
 #include "threads/flags.h"
+#include "threads/heapprof.h"
 #include "threads/interrupt.h"
 #include "threads/intr-stubs.h"
 #include "threads/palloc.h"
 #include "threads/synch.h"
 #include "threads/vaddr.h"
+#include "devices/timer.h"
 #ifdef USERPROG
 #include "userprog/process.h"
 #endif
@@ -24,12 +26,15 @@
    Do not modify this value. */
 #define THREAD_BASIC 0xd42df210
 
-/* List of processes in THREAD_READY state, that is, processes
-   that are ready to run but not actually running. */
-static struct list ready_list;
+/* Per-CPU scheduler state.  The ready queue (processes in
+   THREAD_READY state, that is, processes that are ready to run
+   but not actually running), idle thread and statistics of the
+   processor.  Only the BSP is brought up, so only cpus[0] is used.
+   See struct cpu in thread.h. */
+struct cpu cpus[NCPU_MAX];
 
-/* Idle thread. */
-static struct thread *idle_thread;
+/* # of CPUs in cpus[] that are up and scheduling. Always 1. */
+int ncpu;
 
 /* Initial thread, the thread running init.c:main(). */
 static struct thread *initial_thread;
@@ -40,20 +45,18 @@ static struct lock tid_lock;
 /* Thread destruction requests */
 static struct list destruction_req;
 
-/* Statistics. */
-static long long idle_ticks;   /* # of timer ticks spent idle. */
-static long long kernel_ticks; /* # of timer ticks in kernel threads. */
-static long long user_ticks;   /* # of timer ticks in user programs. */
-
 /* Scheduling. */
-#define TIME_SLICE 4          /* # of timer ticks to give each thread. */
-static unsigned thread_ticks; /* # of timer ticks since last yield. */
+#define TIME_SLICE 4 /* # of timer ticks to give each thread. */
 
 /* If false (default), use round-robin scheduler.
    If true, use multi-level feedback queue scheduler.
    Controlled by kernel command-line option "-o mlfqs". */
 bool thread_mlfqs;
 
+/* If true, use completely fair (vruntime) scheduler.
+   Controlled by kernel command-line option "-sched=cfs". */
+bool thread_cfs;
+
 static void kernel_thread(thread_func *, void *aux);
 
 static void idle(void *aux UNUSED);
@@ -63,6 +66,14 @@ static void do_schedule(int status);
 static void schedule(void);
 static tid_t allocate_tid(void);
 
+/* ------------------- added for CFS ------------------- */
+
+static bool cfs_less_vruntime(const struct rb_node *a,
+                              const struct rb_node *b, void *aux);
+static bool cfs_should_preempt(struct cpu *c, struct thread *curr);
+static void cfs_place_woken(struct cpu *c, struct thread *t);
+static void cfs_tick(struct cpu *c, struct thread *curr);
+
 /* Returns true if T appears to point to a valid thread. */
 #define is_thread(t) ((t) != NULL && (t)->magic == THREAD_MAGIC)
 
@@ -80,15 +91,49 @@ static uint64_t gdt[3] = {0, 0x00af9a000000ffff, 0x00cf92000000ffff};
 
 /* ------------ added for Project.1-1 ------------ */
 
-/* sleep상태(BLOCKED)의 thread list */
-static struct list sleep_list;
+/* sleep상태(BLOCKED)의 thread list
+static struct list sleep_list; */
+
+/* ------------ added for timer wheel ------------
+
+   sleep상태(BLOCKED)의 thread들을 wakeup_ticks에 따라 2단계 hierarchical
+   timing wheel에 보관한다. 매 tick마다 sleep_list 전체를 순회하지 않고
+   현재 tick의 slot에 있는 (깨어나야 할) thread만 처리한다.
+
+   - tv0 : wakeup_ticks가 TW0_SIZE ticks 이내인 thread. slot = 1 tick
+   - tv1 : TW0_SIZE * TW1_SIZE ticks 이내인 thread. slot = TW0_SIZE ticks
+   - tv_overflow : 그 이후의 thread
+
+   tv0가 한바퀴 돌때마다 (wheel_base의 하위 bit가 0) tv1의 다음 slot을
+   tv0로 내려보내고(cascade), tv1이 한바퀴 돌때마다 tv_overflow를 다시
+   분배한다. */
+
+#define TW0_BITS 8
+#define TW1_BITS 6
+#define TW0_SIZE (1 << TW0_BITS) /* 256 slots */
+#define TW1_SIZE (1 << TW1_BITS) /* 64 slots */
+#define TW0_MASK (TW0_SIZE - 1)
+#define TW1_MASK (TW1_SIZE - 1)
+
+static struct list tv0[TW0_SIZE];
+static struct list tv1[TW1_SIZE];
+static struct list tv_overflow;
+
+/* 다음에 처리할 tick. 이 tick 이전의 slot들은 모두 처리되었다. */
+static int64_t wheel_base;
+
+static void timer_wheel_init(void);
+static void timer_wheel_insert(struct thread *t);
+static void timer_wheel_cascade(struct list *slot);
 
 /**
  * @brief t가 idle thread인지 확인한다.
  *
  * @param t thread for compare 
  */
-bool is_idle_thread(struct thread *t) { return t == idle_thread; }
+bool is_idle_thread(struct thread *t) {
+  return t->cpu != NULL && t == t->cpu->idle_thread;
+}
 
 /* ------------ added for Project.1-2 ------------ */
 
@@ -97,13 +142,22 @@ bool is_idle_thread(struct thread *t) { return t == idle_thread; }
  *        thread보다 낮다면 CPU 선점(Running)을 양보한다.
 */
 void check_preempt(void) {
-  if (list_empty(&ready_list)) return;
+  enum intr_level old_level;
+  struct cpu *c;
+  bool preempt;
+
+  old_level = intr_disable(); /* interrupt off */
+  c = this_cpu();
+
+  if (thread_cfs)
+    preempt = cfs_should_preempt(c, thread_current());
+  else
+    preempt = !ready_queue_empty(&c->rq) &&
+              thread_get_priority() < ready_queue_max_priority(&c->rq);
 
-  int curr_t_p = thread_get_priority();
-  int next_t_p =
-      list_entry(list_front(&ready_list), struct thread, elem)->priority;
+  intr_set_level(old_level); /* restore interrupt */
 
-  if (curr_t_p < next_t_p) thread_yield();
+  if (preempt) thread_yield();
 }
 
 /**
@@ -120,6 +174,325 @@ bool cmp_ascending_priority(const struct list_elem *a,
   return (a_t->priority) > (b_t->priority);
 }
 
+/* ---------- added for O(1) ready queue ---------- */
+
+_Static_assert(PRI_CNT <= 64, "ready_queue bitmap holds at most 64 levels");
+
+/* bitmap에서 가장 높은 우선순위 level(최상위 set bit)을 반환한다. */
+#define RQ_TOP_LEVEL(bitmap) (63 - __builtin_clzll(bitmap))
+
+/**
+ * @brief ready queue의 모든 우선순위 queue와 bitmap을 초기화한다.
+ * 
+ * @param rq 초기화할 ready queue
+*/
+void ready_queue_init(struct ready_queue *rq) {
+  ASSERT(rq != NULL);
+
+  for (int i = 0; i < PRI_CNT; i++) list_init(&rq->queues[i]);
+
+  rq->bitmap = 0;
+  rq->size = 0;
+}
+
+/**
+ * @brief t를 t->priority에 해당하는 queue의 맨 뒤에 넣는다. O(1)
+ * 
+ * @param rq ready queue
+ * @param t 넣을 thread
+ * 
+ * @details 같은 우선순위의 thread들은 FIFO(round-robin) 순서를 유지한다.
+*/
+void ready_queue_push(struct ready_queue *rq, struct thread *t) {
+  int level = t->priority - PRI_MIN;
+
+  ASSERT(0 <= level && level < PRI_CNT);
+
+  list_push_back(&rq->queues[level], &t->elem);
+  rq->bitmap |= 1ULL << level;
+  rq->size++;
+}
+
+/**
+ * @brief ready queue에 들어있는 t를 제거한다. O(1)
+ * 
+ * @warning t->priority는 push 했을때의 priority와 같아야 한다.
+ *          READY 상태인 thread의 priority는 thread_update_priority()
+ *          로만 변경해야 하는 이유다.
+*/
+void ready_queue_remove(struct ready_queue *rq, struct thread *t) {
+  int level = t->priority - PRI_MIN;
+
+  ASSERT(0 <= level && level < PRI_CNT);
+
+  list_remove(&t->elem);
+  if (list_empty(&rq->queues[level])) rq->bitmap &= ~(1ULL << level);
+  rq->size--;
+}
+
+/**
+ * @brief 가장 높은 우선순위 queue의 맨 앞 thread를 꺼내 반환한다. O(1)
+ * 
+ * @return 꺼낸 thread, queue가 비어있다면 NULL
+*/
+struct thread *ready_queue_pop(struct ready_queue *rq) {
+  struct list *queue;
+  int level;
+
+  if (rq->bitmap == 0) return NULL;
+
+  level = RQ_TOP_LEVEL(rq->bitmap);
+  queue = &rq->queues[level];
+
+  struct thread *t = list_entry(list_pop_front(queue), struct thread, elem);
+  if (list_empty(queue)) rq->bitmap &= ~(1ULL << level);
+  rq->size--;
+
+  return t;
+}
+
+/**
+ * @brief ready queue에서 가장 높은 우선순위를 반환한다.
+ * 
+ * @warning rq가 비어있지 않아야 한다.
+*/
+int ready_queue_max_priority(const struct ready_queue *rq) {
+  ASSERT(rq->bitmap != 0);
+
+  return PRI_MIN + RQ_TOP_LEVEL(rq->bitmap);
+}
+
+bool ready_queue_empty(const struct ready_queue *rq) {
+  return rq->bitmap == 0;
+}
+
+size_t ready_queue_size(const struct ready_queue *rq) { return rq->size; }
+
+/**
+ * @brief t의 priority를 변경한다. t가 READY 상태라면 새로운 priority의
+ *        queue로 옮긴다. (O(1) requeue)
+ * 
+ * @param t priority를 변경할 thread
+ * @param priority 새로운 priority
+ * 
+ * @details donation, thread_set_priority(), mlfqs 재계산등 priority를
+ *          바꾸는 모든 곳에서 사용한다. ready queue에 들어있는 thread의
+ *          priority를 직접 바꾸면 queue와 bitmap이 어긋나게 된다.
+*/
+void thread_update_priority(struct thread *t, int priority) {
+  enum intr_level old_level;
+
+  ASSERT(PRI_MIN <= priority && priority <= PRI_MAX);
+
+  old_level = intr_disable(); /* interrupt off */
+
+  /* CFS의 cfs_rq는 priority와 상관없이 vruntime 순이다. */
+  if (t->status == THREAD_READY && t->priority != priority && !thread_cfs) {
+    struct cpu *c = t->cpu;
+
+    ready_queue_remove(&c->rq, t);
+    t->priority = priority;
+    ready_queue_push(&c->rq, t);
+  } else
+    t->priority = priority;
+
+  intr_set_level(old_level); /* restore interrupt */
+}
+
+/* ----------- added for per-CPU run queue ----------- */
+
+/**
+ * @brief 현재 코드를 실행중인 CPU를 반환한다.
+ * 
+ * @note AP(application processor)를 깨우는 코드가 아직 없어 BSP 하나만
+ *       scheduling 하므로 항상 cpus[0]이다. AP를 깨운다면 local APIC ID로
+ *       cpus[]를 찾아야 한다.
+*/
+struct cpu *this_cpu(void) { return &cpus[0]; }
+
+/* CPU c의 scheduler 상태를 초기화한다. */
+static void cpu_init(struct cpu *c, int id) {
+  memset(c, 0, sizeof *c);
+  c->id = id;
+  ready_queue_init(&c->rq);
+  rb_init(&c->cfs_rq, cfs_less_vruntime, NULL);
+}
+
+/**
+ * @brief t를 CPU c의 ready queue(CFS라면 cfs_rq)에 넣는다.
+ * 
+ * @warning interrupt가 꺼진 상태에서 호출해야 한다.
+*/
+static void rq_enqueue(struct cpu *c, struct thread *t) {
+  t->cpu = c;
+
+  if (thread_cfs) {
+    rb_insert(&c->cfs_rq, &t->cfs_elem);
+    c->cfs_weight += cfs_nice_to_weight(t->nice);
+  } else
+    ready_queue_push(&c->rq, t);
+}
+
+/**
+ * @brief CPU c에서 다음에 실행할 thread를 꺼낸다.
+ *        (가장 높은 우선순위, CFS라면 가장 작은 vruntime)
+ * 
+ * @return 꺼낸 thread, 비어있다면 NULL
+ * 
+ * @warning interrupt가 꺼진 상태에서 호출해야 한다.
+*/
+static struct thread *rq_dequeue(struct cpu *c) {
+  struct rb_node *node;
+  struct thread *t;
+
+  if (!thread_cfs) return ready_queue_pop(&c->rq);
+
+  node = rb_pop_min(&c->cfs_rq);
+  if (node == NULL) return NULL;
+
+  t = rb_entry(node, struct thread, cfs_elem);
+  c->cfs_weight -= cfs_nice_to_weight(t->nice);
+
+  return t;
+}
+
+/* CPU c의 READY thread 개수를 반환한다. */
+static size_t rq_size(struct cpu *c) {
+  return thread_cfs ? rb_size(&c->cfs_rq) : ready_queue_size(&c->rq);
+}
+
+
+/* ------------------- added for CFS -------------------
+   Completely fair scheduler. READY thread를 vruntime(nice로 가중치를 준
+   누적 실행 시간)순 red-black tree에 넣고 가장 작은 vruntime의 thread를
+   실행한다. 그래서 각 thread는 weight에 비례하는 CPU 시간을 받는다. */
+
+#define NICE_0_WEIGHT 1024 /* nice 0의 weight */
+#define CFS_TICK 1024      /* nice 0 thread가 1 tick 동안 얻는 vruntime */
+#define CFS_LATENCY 8      /* READY thread가 한번씩 실행되는 목표 주기(ticks) */
+#define CFS_MIN_GRANULARITY 1 /* 한번 실행되면 보장되는 최소 시간 (ticks) */
+
+/* 깨어난 thread의 vruntime이 이 값 이상 작아야 running thread를 선점한다. */
+#define CFS_WAKEUP_GRANULARITY CFS_TICK
+
+/* 깨어난 thread는 min_vruntime 보다 이만큼 작은 vruntime까지 받을 수 있다.
+   (sleeper credit) 오래 잔 thread가 CPU를 독점하지 않도록 상한을 둔다. */
+#define CFS_SLEEPER_CREDIT (CFS_LATENCY * CFS_TICK / 2)
+
+/* nice(-20 ~ 20)별 weight. nice가 1 커질때마다 약 1.25배 작아진다.
+   (Linux의 sched_prio_to_weight, nice 20은 추가) */
+static const int nice_to_weight[NICE_MAX - NICE_MIN + 1] = {
+    /* -20 */ 88761, 71755, 56483, 46273, 36291,
+    /* -15 */ 29154, 23254, 18705, 14949, 11916,
+    /* -10 */ 9548,  7620,  6100,  4904,  3906,
+    /*  -5 */ 3121,  2501,  1991,  1586,  1277,
+    /*   0 */ 1024,  820,   655,   526,   423,
+    /*   5 */ 335,   272,   215,   172,   137,
+    /*  10 */ 110,   87,    70,    56,    45,
+    /*  15 */ 36,    29,    23,    18,    15,
+    /*  20 */ 12,
+};
+
+/* nice에 해당하는 CFS weight를 반환한다. */
+int cfs_nice_to_weight(int nice) {
+  ASSERT(NICE_MIN <= nice && nice <= NICE_MAX);
+
+  return nice_to_weight[nice - NICE_MIN];
+}
+
+/* cfs_rq의 정렬 기준. vruntime이 같다면 먼저 들어온 thread가 앞이다. */
+static bool cfs_less_vruntime(const struct rb_node *a,
+                              const struct rb_node *b, void *aux UNUSED) {
+  return rb_entry(a, struct thread, cfs_elem)->vruntime <
+         rb_entry(b, struct thread, cfs_elem)->vruntime;
+}
+
+/**
+ * @brief c->min_vruntime을 running thread와 cfs_rq의 가장 작은 vruntime
+ *        으로 올린다. (절대 줄어들지 않는다.)
+*/
+static void cfs_update_min_vruntime(struct cpu *c) {
+  struct rb_node *left = rb_min(&c->cfs_rq);
+  int64_t vruntime = INT64_MAX;
+
+  if (c->curr != NULL && !is_idle_thread(c->curr))
+    vruntime = c->curr->vruntime;
+  if (left != NULL) {
+    int64_t left_vruntime = rb_entry(left, struct thread, cfs_elem)->vruntime;
+    if (left_vruntime < vruntime) vruntime = left_vruntime;
+  }
+
+  if (vruntime != INT64_MAX && vruntime > c->min_vruntime)
+    c->min_vruntime = vruntime;
+}
+
+/**
+ * @brief cfs_rq에서 기다리는 thread가 running thread curr을 선점해야
+ *        하는지 확인한다.
+ * 
+ * @warning interrupt가 꺼진 상태에서 호출해야 한다.
+*/
+static bool cfs_should_preempt(struct cpu *c, struct thread *curr) {
+  struct rb_node *left = rb_min(&c->cfs_rq);
+  int64_t left_vruntime;
+
+  if (left == NULL) return false;
+  if (is_idle_thread(curr)) return true;
+
+  left_vruntime = rb_entry(left, struct thread, cfs_elem)->vruntime;
+  return left_vruntime + CFS_WAKEUP_GRANULARITY < curr->vruntime;
+}
+
+/**
+ * @brief 깨어난 thread t의 vruntime을 정한다. (sleeper credit)
+ * 
+ * @details 잠든동안 vruntime이 늘지 않으므로 그대로 두면 오래 잔 thread가
+ *          다른 thread들을 따라잡을때까지 CPU를 독점한다. 그래서
+ *          min_vruntime - CFS_SLEEPER_CREDIT 보다 작아지지 않게 한다.
+ *          자주 자는 interactive thread는 조금 앞에 서게 되어 빨리 실행된다.
+ * 
+ *          한번도 실행되지 않은 새 thread(t->cpu == NULL)는 잔 적이 없으므로
+ *          credit 없이 min_vruntime에 둔다. 그렇지 않으면 thread를 계속
+ *          만드는 것만으로 다른 thread들보다 앞에 설 수 있다.
+ * 
+ * @warning interrupt가 꺼진 상태에서 호출해야 한다.
+*/
+static void cfs_place_woken(struct cpu *c, struct thread *t) {
+  int64_t floor = c->min_vruntime;
+
+  if (t->cpu != NULL) floor -= CFS_SLEEPER_CREDIT;
+  if (t->vruntime < floor) t->vruntime = floor;
+}
+
+/**
+ * @brief timer interrupt마다 running thread의 vruntime을 늘리고 선점
+ *        여부를 정한다.
+ * 
+ * @details 한번에 실행할 수 있는 시간(slice)은 CFS_LATENCY를 READY thread
+ *          들의 weight 비율로 나눈 값이다. slice를 다 썼거나 vruntime이 더
+ *          작은 thread가 있다면 interrupt에서 돌아갈때 양보한다.
+*/
+static void cfs_tick(struct cpu *c, struct thread *curr) {
+  int64_t weight, slice;
+  bool preempt;
+
+  if (is_idle_thread(curr)) return;
+
+  weight = cfs_nice_to_weight(curr->nice);
+  curr->vruntime += CFS_TICK * NICE_0_WEIGHT / weight;
+  c->thread_ticks++;
+
+  cfs_update_min_vruntime(c);
+
+  slice = CFS_LATENCY * weight / (c->cfs_weight + weight);
+  if (slice < CFS_MIN_GRANULARITY) slice = CFS_MIN_GRANULARITY;
+
+  preempt = !rb_empty(&c->cfs_rq) &&
+            (c->thread_ticks >= slice || cfs_should_preempt(c, curr));
+
+  if (preempt) intr_yield_on_return();
+}
+
 /* ------------ added for Project.1-3 ------------ */
 
 /***************** global variable *****************/
@@ -130,6 +503,23 @@ int load_avg = LOAD_AVG_DEFAULT;
 /* thread_create()로 생성된 **모든** thread를 저장하는 list */
 struct list active_list;
 
+/* ------------ incremental mlfqs ------------
+   recent_cpu의 decay는 매 초(epoch)마다 모든 thread에 적용되어야 하지만
+   BLOCKED thread는 스케쥴링에 참여하지 않기에 깨어날때 밀린 decay를 한번에
+   적용한다(lazy). 이를 위해 매 초의 decay 값을 history에 기록해둔다. */
+
+#define MLFQS_HISTORY 64        /* 기록해두는 decay의 개수 (초) */
+#define MLFQS_CATCH_UP_MAX 1024 /* 한번에 적용하는 decay의 최대 횟수 */
+
+/* 부팅 이후 지난 초(load_avg/decay를 갱신한 횟수) */
+static int mlfqs_epoch;
+
+/* decay_history[e % MLFQS_HISTORY] : epoch e에 적용할 decay [F_P] */
+static int decay_history[MLFQS_HISTORY];
+
+static void mlfqs_refresh_ready_threads(void);
+static int thread_calc_priority_mlfqs(struct thread *t);
+
 /***************************************************/
 
 /*************** function definition ***************/
@@ -147,6 +537,18 @@ struct list active_list;
  *            result = (    result_left_term      - (nice * 2))
 */
 void thread_set_priority_mlfqs(struct thread *t, void *aux UNUSED) {
+  int result = thread_calc_priority_mlfqs(t);
+
+  thread_update_priority(t, result);
+  t->initial_priority = result;
+}
+
+/**
+ * @brief t의 recent_cpu와 nice로 mlfqs priority를 계산해 반환한다.
+ * 
+ * @ref thread_set_priority_mlfqs()
+*/
+static int thread_calc_priority_mlfqs(struct thread *t) {
   int recent_cpu = t->recent_cpu;
   int nice = INT_TO_FP(t->nice);
 
@@ -156,20 +558,12 @@ void thread_set_priority_mlfqs(struct thread *t, void *aux UNUSED) {
   int result_left_term = SUB_FP(INT_TO_FP(PRI_MAX), recent_cpu_term);
   int result = FP_TO_INT_NEAREST(SUB_FP(result_left_term, nice_term));
 
-  if (result < PRI_MIN) {
-    t->priority = PRI_MIN;
-    t->initial_priority = PRI_MIN;
-    return;
-  }
-
-  else if (result > PRI_MAX) {
-    t->priority = PRI_MAX;
-    t->initial_priority = PRI_MAX;
-    return;
-  }
+  if (result < PRI_MIN)
+    result = PRI_MIN;
+  else if (result > PRI_MAX)
+    result = PRI_MAX;
 
-  t->priority = result;
-  t->initial_priority = result;
+  return result;
 }
 
 /**
@@ -242,9 +636,12 @@ void thread_update_load_avg(void) {
 
   old_level = intr_disable(); /* interrupt off */
 
-  int threads_cnt = (thread_current() == idle_thread)
-                        ? list_size(&ready_list)
-                        : list_size(&ready_list) + 1;
+  int threads_cnt = 0;
+
+  for (int i = 0; i < ncpu; i++) {
+    threads_cnt += rq_size(&cpus[i]);
+    if (!is_idle_thread(cpus[i].curr)) threads_cnt++;
+  }
 
   load_avg = thread_calc_load_avg(load_avg, threads_cnt);
 
@@ -279,28 +676,133 @@ int thread_get_recent_cpu(void) {
 }
 
 /**
- * @brief 모든 thread를 순회하며 recent_cpu를 변경할때 사용하는 함수
+ * @brief t에 아직 적용되지 않은 매 초의 recent_cpu decay를 적용한다.
  * 
  * @details recent_cpu = decay * recent_cpu + nice
  *                       (result_left_term)
  *              result = (result_left_term  + nice)
+ * 
+ *          t->recent_cpu_epoch 부터 mlfqs_epoch 까지 밀린 epoch마다
+ *          그 시점의 decay(decay_history)로 위 식을 적용한다.
+ *          이미 최신이라면 아무것도 하지 않으므로 여러번 호출해도 된다.
+ * 
+ * @note MLFQS_HISTORY초 보다 오래 BLOCKED 상태였다면 기록이 남아있지 않은
+ *       epoch는 가장 오래된 decay로 근사하고, MLFQS_CATCH_UP_MAX번
+ *       이상은 적용하지 않는다. (그 정도면 recent_cpu는 이미 수렴했다.)
 */
 void thread_update_recent_cpu(struct thread *t, void *aux UNUSED) {
   enum intr_level old_level;
   old_level = intr_disable(); /* interrupt off */
 
-  struct thread *curr_t = t;
-  int recent_cpu = curr_t->recent_cpu;
-  int decay = thread_calc_decay();
+  int epoch = t->recent_cpu_epoch;
+  int oldest = mlfqs_epoch - MLFQS_HISTORY;
+
+  if (mlfqs_epoch - epoch > MLFQS_CATCH_UP_MAX)
+    epoch = mlfqs_epoch - MLFQS_CATCH_UP_MAX;
 
-  int left_term = MUL_FP(decay, recent_cpu);
-  int result = ADD_FP_AND_INT(left_term, curr_t->nice);
+  for (; epoch < mlfqs_epoch; epoch++) {
+    int idx = (epoch < oldest ? oldest : epoch) % MLFQS_HISTORY;
+    int decay = decay_history[idx];
 
-  curr_t->recent_cpu = result;
+    int left_term = MUL_FP(decay, t->recent_cpu);
+    t->recent_cpu = ADD_FP_AND_INT(left_term, t->nice);
+  }
+
+  t->recent_cpu_epoch = mlfqs_epoch;
 
   intr_set_level(old_level); /* restore interrupt */
 }
 
+/**
+ * @brief mlfqs일때 timer interrupt마다 호출되어 recent_cpu, load_avg,
+ *        priority를 갱신한다.
+ * 
+ * @param ticks timer_ticks()
+ * 
+ * @details 모든 thread를 순회하던 이전 방식과 달리 값이 바뀌는 thread만
+ *          갱신한다.
+ * 
+ *          - 매 tick : running thread의 recent_cpu만 증가한다.
+ *          - 4 ticks : recent_cpu가 바뀐 thread는 running thread 뿐이므로
+ *                      running thread의 priority만 다시 계산한다.
+ *          - 1 초    : load_avg와 decay를 계산해 history에 기록하고
+ *                      running, READY thread만 갱신한다. BLOCKED thread는
+ *                      thread_unblock()에서 밀린 decay를 적용한다.
+*/
+void thread_mlfqs_tick(int64_t ticks) {
+  struct thread *curr_t = thread_current();
+
+  ASSERT(intr_get_level() == INTR_OFF);
+
+  /* each ticks excute */
+  thread_increase_recent_cpu_of_running();
+
+  /* every 1 second */
+  if (ticks % TIMER_FREQ == 0) {
+    thread_update_load_avg();
+
+    decay_history[mlfqs_epoch % MLFQS_HISTORY] = thread_calc_decay();
+    mlfqs_epoch++;
+
+    if (!is_idle_thread(curr_t)) thread_update_recent_cpu(curr_t, NULL);
+    mlfqs_refresh_ready_threads();
+  }
+
+  /* every 4 ticks */
+  if (ticks % 4 == 0 && !is_idle_thread(curr_t))
+    thread_set_priority_mlfqs(curr_t, NULL);
+}
+
+/**
+ * @brief 모든 CPU의 ready queue에 있는 thread에 밀린 decay를 적용하고
+ *        priority를 다시 계산한다.
+ * 
+ * @details priority가 바뀐 thread는 다른 level의 queue로 옮겨진다.
+ *          아직 방문하지 않은 level로 옮겨졌다면 다시 방문하게 되지만 이미
+ *          최신 상태이므로 아무것도 바뀌지 않는다.
+ * 
+ *          interrupt를 끈채로 순회하므로 thread_update_priority() 대신
+ *          직접 queue를 옮긴다.
+*/
+static void mlfqs_refresh_ready_threads(void) {
+  for (int i = 0; i < ncpu; i++) {
+    struct cpu *c = &cpus[i];
+
+    for (int level = 0; level < PRI_CNT; level++) {
+      struct list *queue = &c->rq.queues[level];
+      struct list_elem *e = list_begin(queue);
+
+      while (e != list_end(queue)) {
+        struct thread *t = list_entry(e, struct thread, elem);
+        int priority;
+        e = list_next(e);
+
+        thread_update_recent_cpu(t, NULL);
+        priority = thread_calc_priority_mlfqs(t);
+        t->initial_priority = priority;
+        if (priority == t->priority) continue;
+
+        ready_queue_remove(&c->rq, t);
+        t->priority = priority;
+        ready_queue_push(&c->rq, t);
+      }
+    }
+  }
+}
+
+/**
+ * @brief t의 recent_cpu를 최신으로 만들고 priority를 다시 계산한다.
+ * 
+ * @details BLOCKED 상태였던 thread가 깨어날때(thread_unblock),
+ *          semaphore waiters 중 누구를 깨울지 고를때(sema_up) 사용한다.
+*/
+void thread_refresh_mlfqs(struct thread *t) {
+  if (!thread_mlfqs || is_idle_thread(t)) return;
+
+  thread_update_recent_cpu(t, NULL);
+  thread_set_priority_mlfqs(t, NULL);
+}
+
 /**
  * @brief Running thread의 recent_cpu를 1 증가시킨다.
 */
@@ -376,7 +878,9 @@ void thread_sleep(int64_t ticks) {
 
   thread_set_wakeup_ticks(curr_t, ticks); /* ticks 설정 */
 
-  list_push_back(&sleep_list, &curr_t->elem); /* sleep_list에 넣어준다*/
+  /* list_push_back(&sleep_list, &curr_t->elem); sleep_list에 넣어준다 */
+
+  timer_wheel_insert(curr_t); /* timing wheel에 넣어준다 */
 
   /* ------------ Project.1-1 solution[1] ------------
     thread_block(); */
@@ -392,31 +896,88 @@ void thread_sleep(int64_t ticks) {
 }
 
 /**
- * @brief sleep_list를 순회하면서 특정 시간이 지난 thread를 깨운다
+ * @brief timing wheel에서 ticks까지 깨어나야 할 thread를 깨운다
  *
  * @param ticks timer_ticks() : start
+ * 
+ * @details 보통 매 tick마다 호출되므로 while문은 한번만 돈다.
+ *          비용은 깨어나는 thread의 수 + (tv0가 한바퀴 돌때) cascade 되는
+ *          thread의 수에 비례한다.
  */
 void thread_check_awake(int64_t ticks) {
-  struct list_elem *curr_ll_e;
-  struct thread *curr_t;
+  struct list *slot;
+  int idx0, idx1;
 
-  curr_ll_e = list_begin(&sleep_list);
+  ASSERT(intr_get_level() == INTR_OFF);
 
-  while (1) {
-    if (curr_ll_e == list_end(&sleep_list)) break;
+  while (wheel_base <= ticks) {
+    idx0 = wheel_base & TW0_MASK;
 
-    curr_t = list_entry(curr_ll_e, struct thread, elem);
+    if (idx0 == 0) {
+      idx1 = (wheel_base >> TW0_BITS) & TW1_MASK;
 
-    if (curr_t->wakeup_ticks <= ticks) {
-      curr_ll_e = list_remove(curr_ll_e);
-      thread_unblock(curr_t);
-      continue;
+      if (idx1 == 0) timer_wheel_cascade(&tv_overflow);
+      timer_wheel_cascade(&tv1[idx1]);
     }
 
-    curr_ll_e = list_next(curr_ll_e);
+    slot = &tv0[idx0];
+    while (!list_empty(slot))
+      thread_unblock(list_entry(list_pop_front(slot), struct thread, elem));
+
+    wheel_base++;
   }
 }
 
+/**
+ * @brief timing wheel의 모든 slot을 초기화한다.
+*/
+static void timer_wheel_init(void) {
+  for (int i = 0; i < TW0_SIZE; i++) list_init(&tv0[i]);
+  for (int i = 0; i < TW1_SIZE; i++) list_init(&tv1[i]);
+  list_init(&tv_overflow);
+
+  wheel_base = 0;
+}
+
+/**
+ * @brief t->wakeup_ticks에 맞는 timing wheel의 slot에 t를 넣는다. O(1)
+ * 
+ * @details 이미 지난 wakeup_ticks(ex. timer_sleep(0), 음수)라면
+ *          다음에 처리할 slot에 넣어 다음 tick에 깨운다.
+*/
+static void timer_wheel_insert(struct thread *t) {
+  int64_t expires = t->wakeup_ticks;
+  int64_t delta = expires - wheel_base;
+  struct list *slot;
+
+  if (delta < 0)
+    slot = &tv0[wheel_base & TW0_MASK];
+  else if (delta < TW0_SIZE)
+    slot = &tv0[expires & TW0_MASK];
+  else if (delta < TW0_SIZE * TW1_SIZE)
+    slot = &tv1[(expires >> TW0_BITS) & TW1_MASK];
+  else
+    slot = &tv_overflow;
+
+  list_push_back(slot, &t->elem);
+}
+
+/**
+ * @brief slot에 있는 thread들을 현재 wheel_base 기준으로 다시 분배한다.
+*/
+static void timer_wheel_cascade(struct list *slot) {
+  struct list pending;
+
+  /* 다시 넣을때 같은 slot으로 돌아올 수 있으므로 (tv_overflow) 
+     먼저 떼어낸 뒤 분배한다. */
+  list_init(&pending);
+  while (!list_empty(slot)) list_push_back(&pending, list_pop_front(slot));
+
+  while (!list_empty(&pending))
+    timer_wheel_insert(
+        list_entry(list_pop_front(&pending), struct thread, elem));
+}
+
 /**
  * @brief thread가 깨어날 시간을 설정한다.
  *
@@ -468,14 +1029,23 @@ void thread_init(void) {
   lgdt(&gdt_ds);
 
   /* Init the globla thread context */
+#ifdef LOCKSTAT
+  lockstat_init(); /* added for lock statistics : 첫 lock_init() 전에 */
+#endif
   lock_init(&tid_lock);
 
-  list_init(&ready_list);
   list_init(&destruction_req);
 
+  /* ------------ added for per-CPU run queue ------------ */
+
+  cpu_init(&cpus[0], 0); /* BSP */
+  ncpu = 1;
+
   /* --------------- added for PROJECT.1-1 --------------- */
 
-  list_init(&sleep_list);
+  /* list_init(&sleep_list); */
+
+  timer_wheel_init();
 
   /* --------------- added for PROJECT.1-3 --------------- */
 
@@ -488,6 +1058,8 @@ void thread_init(void) {
   init_thread(initial_thread, "main", PRI_DEFAULT);
   initial_thread->status = THREAD_RUNNING;
   initial_thread->tid = allocate_tid();
+  initial_thread->cpu = this_cpu();
+  this_cpu()->curr = initial_thread;
 
   /* ------------ after Project.1-3 ------------ */
 
@@ -548,22 +1120,34 @@ void thread_start(void) {
    Thus, this function runs in an external interrupt context. */
 void thread_tick(void) {
   struct thread *t = thread_current();
+  struct cpu *c = this_cpu();
 
   /* Update statistics. */
-  if (t == idle_thread) idle_ticks++;
+  if (t == c->idle_thread) c->idle_ticks++;
 #ifdef USERPROG
   else if (t->pml4 != NULL)
-    user_ticks++;
+    c->user_ticks++;
 #endif
   else
-    kernel_ticks++;
+    c->kernel_ticks++;
 
   /* Enforce preemption. */
-  if (++thread_ticks >= TIME_SLICE) intr_yield_on_return();
+  if (thread_cfs)
+    cfs_tick(c, t);
+  else if (++c->thread_ticks >= TIME_SLICE)
+    intr_yield_on_return();
 }
 
 /* Prints thread statistics. */
 void thread_print_stats(void) {
+  long long idle_ticks = 0, kernel_ticks = 0, user_ticks = 0;
+
+  for (int i = 0; i < ncpu; i++) {
+    idle_ticks += cpus[i].idle_ticks;
+    kernel_ticks += cpus[i].kernel_ticks;
+    user_ticks += cpus[i].user_ticks;
+  }
+
   printf("Thread: %lld idle ticks, %lld kernel ticks, %lld user ticks\n",
          idle_ticks, kernel_ticks, user_ticks);
 }
@@ -705,6 +1289,7 @@ void thread_block(void) {
 */
 void thread_unblock(struct thread *t) {
   enum intr_level old_level;
+  struct cpu *c;
 
   ASSERT(is_thread(t));
 
@@ -714,9 +1299,31 @@ void thread_unblock(struct thread *t) {
   /* ---------- before Project.1-2 ----------
   list_push_back(&ready_list, &t->elem); */
 
-  /* ---------- after Project.1-2 ---------- */
+  /* ---------- after Project.1-2 ----------
+  list_insert_ordered(&ready_list, &(t->elem), cmp_ascending_priority, NULL); */
+
+  /* ------- after O(1) ready queue ------- */
+
+  /* BLOCKED 동안 밀린 recent_cpu decay를 적용한다. (incremental mlfqs) */
+  thread_refresh_mlfqs(t);
+
+  /* 마지막으로 실행된 CPU의 ready queue에 넣는다. (cache affinity)
+     한번도 실행되지 않은 thread라면 현재 CPU에 넣는다. */
+  c = t->cpu != NULL ? t->cpu : this_cpu();
+
+  if (thread_cfs) {
+    bool preempt;
 
-  list_insert_ordered(&ready_list, &(t->elem), cmp_ascending_priority, NULL);
+    cfs_place_woken(c, t);
+    rq_enqueue(c, t);
+    preempt = intr_context() && c == this_cpu() &&
+              cfs_should_preempt(c, thread_current());
+
+    /* interrupt handler에서 깨웠다면 (e.g. timer) 돌아갈때 선점한다.
+       바로 선점하지는 않으므로 위에 적힌 약속은 지켜진다. */
+    if (preempt) intr_yield_on_return();
+  } else
+    rq_enqueue(c, t);
 
   /* --------------------------------------- */
 
@@ -768,6 +1375,7 @@ void thread_exit(void) {
 #ifdef USERPROG
   process_exit();
 #endif
+  heapprof_print_leaks(thread_current()->tid); /* added for heap profiler */
 
   /* Just set our status to dying and schedule another process.
      We will be destroyed during the call to schedule_tail(). */
@@ -803,9 +1411,12 @@ void thread_yield(void) {
   /* before Project.1-2 */
   // if (curr != idle_thread) list_push_back(&ready_list, &curr->elem);
 
-  /* after Project.1-2 */
+  /* after Project.1-2
   if (curr != idle_thread)
-    list_insert_ordered(&ready_list, &curr->elem, cmp_ascending_priority, NULL);
+    list_insert_ordered(&ready_list, &curr->elem, cmp_ascending_priority, NULL); */
+
+  /* after O(1) ready queue */
+  if (!is_idle_thread(curr)) rq_enqueue(this_cpu(), curr);
 
   do_schedule(THREAD_READY);
   intr_set_level(old_level);
@@ -862,7 +1473,7 @@ int thread_get_priority(void) { return thread_current()->priority; }
 static void idle(void *idle_started_ UNUSED) {
   struct semaphore *idle_started = idle_started_;
 
-  idle_thread = thread_current();
+  this_cpu()->idle_thread = thread_current();
   sema_up(idle_started);
 
   for (;;) {
@@ -925,12 +1536,17 @@ static void init_thread(struct thread *t, const char *name, int priority) {
 
   t->initial_priority = priority;
   t->wait_on_lock = NULL;
-  list_init(&t->donations);
+  list_init(&t->held_locks);
 
   /* ----------- added for PROJECT.1-3 ----------- */
 
   t->nice = NICE_DEFAULT;
   t->recent_cpu = RECENT_CPU_DEFAULT;
+  t->recent_cpu_epoch = mlfqs_epoch;
+
+  /* ----------- added for CFS ----------- */
+
+  t->vruntime = this_cpu()->min_vruntime;
 
   /* ----------- added for PROJECT.2-2(Hierarchy) ----------- */
 
@@ -963,10 +1579,10 @@ static void init_thread(struct thread *t, const char *name, int priority) {
  * 
 */
 static struct thread *next_thread_to_run(void) {
-  if (list_empty(&ready_list))
-    return idle_thread;
-  else
-    return list_entry(list_pop_front(&ready_list), struct thread, elem);
+  struct cpu *c = this_cpu();
+  struct thread *next = rq_dequeue(c);
+
+  return (next != NULL) ? next : c->idle_thread;
 }
 
 /**
@@ -1032,7 +1648,9 @@ void do_iret(struct intr_frame *tf) {
  *         >  실제로는 printf()가 함수의 끝에 추가되어야 합니다.
  * 
  */
-static void thread_launch(struct thread *th) {
+/* noinline: the asm below defines the global labels __next and
+   out_iret, which must not be duplicated at -O2/LTO. */
+static void __attribute__((noinline)) thread_launch(struct thread *th) {
 
   uint64_t tf_cur = (uint64_t)&running_thread()->tf;
   uint64_t tf = (uint64_t)&th->tf;
@@ -1088,8 +1706,11 @@ static void thread_launch(struct thread *th) {
       "call do_iret\n"
       "out_iret:\n"
       :
-      : "g"(tf_cur), "g"(tf)
-      : "memory");
+      /* "r" and the clobbers keep the inputs out of memory operands
+         relative to %rsp, which the pushes above move, and out of
+         the registers the asm overwrites before reading them. */
+      : "r"(tf_cur), "r"(tf)
+      : "rax", "rbx", "rcx", "memory");
 }
 
 /**
@@ -1138,9 +1759,11 @@ static void schedule(void) {
   ASSERT(is_thread(next));
   /* Mark us as running. */
   next->status = THREAD_RUNNING;
+  next->cpu = this_cpu();
+  this_cpu()->curr = next;
 
   /* Start new time slice. */
-  thread_ticks = 0;
+  this_cpu()->thread_ticks = 0;
 
 #ifdef USERPROG
   /* Activate the new address space. */
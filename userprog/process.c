@@ -14,6 +14,7 @@
 #include "threads/interrupt.h"
 #include "threads/mmu.h"
 #include "threads/palloc.h"
+#include "threads/slab.h"
 #include "threads/thread.h"
 #include "threads/vaddr.h"
 #include "userprog/gdt.h"
@@ -39,7 +40,7 @@ static void fdt_cleanup() {
     struct fd_elem *tmp = list_entry(e, struct fd_elem, elem);
     struct file *file_ptr = tmp->file_ptr;
     file_close(file_ptr);
-    free(tmp);
+    kmem_cache_free(fd_elem_cachep, tmp);
   }
 }
 
@@ -397,7 +398,7 @@ static void __do_fork(void *aux) {
     struct file *dup_file = file_duplicate(tmp->file_ptr);
     if (dup_file == NULL) goto error;
 
-    struct fd_elem *e = (struct fd_elem *)malloc(sizeof(struct fd_elem));
+    struct fd_elem *e = kmem_cache_alloc(fd_elem_cachep);
     if (e == NULL) goto error;
 
     e->file_ptr = dup_file;
@@ -461,9 +462,7 @@ int process_exec(void *f_name) {
   process_cleanup();
 
   /* And then load the binary */
-  lock_acquire(&filesys_lock);
   success = load(argv[0], &_if);
-  lock_release(&filesys_lock);
 
   /* If load failed, quit. */
   if (!success) return -1;
@@ -554,6 +553,10 @@ void process_exit(void) {
   /* CLOSE : 열려있는 file을 모두 닫고 fd Table을 deallocate ! */
   fdt_cleanup();
 
+  /* read()/write()가 쓰던 bounce page를 돌려준다. (added for per-inode rwlock) */
+  palloc_free_page(curr_t->io_buf);
+  curr_t->io_buf = NULL;
+
   for (struct list_elem *e = list_begin(&curr_t->child_list);
        e != list_end(&curr_t->child_list); e = list_next(e)) {
     child_t = list_entry(e, struct thread, child_elem);
@@ -1003,7 +1006,7 @@ static bool lazy_load_segment(struct page *page, void *aux) {
 
   /* file에서 실제 읽은 bytes와 읽어야할 bytes가 다르다면 throw */
   if ((uint32_t)actually_read_bytes != read_bytes) {
-    free(aux);
+    kmem_cache_free(file_segment_cachep, aux);
     goto done;
   }
 
@@ -1011,6 +1014,11 @@ static bool lazy_load_segment(struct page *page, void *aux) {
   memset(physical_addr + actually_read_bytes, 0, zero_bytes);
   result = true;
 
+  /* added for fault-around : load가 끝난 aux는 더 이상 쓰지 않는다.
+     vm_claim_segment()도 같은 방법으로 정리한다. */
+  file_close(file);
+  kmem_cache_free(file_segment_cachep, aux);
+
 done:
   return result;
 }
@@ -1036,19 +1044,13 @@ static bool load_segment(struct file *file, off_t ofs, uint8_t *upage,
   ASSERT(pg_ofs(upage) == 0);
   ASSERT(ofs % PGSIZE == 0);
 
+  /* ------- before VMA -------
+     page마다 struct page와 aux를 만들어 spt에 넣었다.
   while (read_bytes > 0 || zero_bytes > 0) {
-    /* Do calculate how to fill this page.
-		 * We will read PAGE_READ_BYTES bytes from FILE
-		 * and zero the final PAGE_ZERO_BYTES bytes.
-     * 
-     * >  이 페이지를 어떻게 채울지 계산하십시오.
-     * >  FILE에서 PAGE_READ_BYTES 바이트를 읽을 것입니다.
-     * >  그리고 마지막 PAGE_ZERO_BYTES 바이트를 0으로 설정합니다. */
     size_t page_read_bytes = read_bytes < PGSIZE ? read_bytes : PGSIZE;
     size_t page_zero_bytes = PGSIZE - page_read_bytes;
 
-    /* TODO: Set up aux to pass information to the lazy_load_segment. */
-    struct file_segment_info *aux = calloc(1, sizeof(struct file_segment_info));
+    struct file_segment_info *aux = kmem_cache_zalloc(file_segment_cachep);
     if (aux == NULL) return false;
 
     aux->file = file_duplicate(file);
@@ -1060,13 +1062,18 @@ static bool load_segment(struct file *file, off_t ofs, uint8_t *upage,
                                         lazy_load_segment, aux))
       return false;
 
-    /* Advance. */
     read_bytes -= page_read_bytes;
     zero_bytes -= page_zero_bytes;
     upage += PGSIZE;
     ofs += page_read_bytes;
-  }
-  return true;
+  } */
+
+  /* segment 전체를 area 하나로 등록한다. page는 처음 접근할 때 만든다.
+     읽기 전용 segment(text)는 file page로 만들어 process끼리 frame을 공유한다.
+     (added for shared text) */
+  return vm_map_area(upage, read_bytes + zero_bytes, writable,
+                     writable ? VM_ANON : VM_FILE, file, ofs, read_bytes,
+                     lazy_load_segment) != NULL;
 }
 
 /**
@@ -1,5 +1,6 @@
 #include "userprog/syscall.h"
 #include <stdio.h>
+#include <string.h>
 #include <syscall-nr.h>
 #include "filesys/filesys.h"   /* added for PROJECT.2-2 */
 #include "include/lib/stdio.h" /* added for PROJECT.2-2 STD_FILENO */
@@ -8,14 +9,29 @@
 #include "threads/flags.h"
 #include "threads/interrupt.h"
 #include "threads/loader.h"
+#include "threads/palloc.h" /* added for per-inode rwlock */
+#include "threads/slab.h"
 #include "threads/synch.h" /* added for PROJECT.2-2 */
 #include "threads/thread.h"
 #include "userprog/gdt.h"
 #include "userprog/process.h" /* added for PROJECT.2-2 */
+#ifdef VM
+#include "threads/vaddr.h"
+#include "vm/file.h" /* added for mmap */
+#endif
 
 void syscall_entry(void);
 void syscall_handler(struct intr_frame *);
 
+#ifdef VM
+/* added for mmap : do_mmap(), do_munmap()은 vm/file.c의 이름이다. */
+static void *sys_mmap(void *addr, size_t length, int writable, int fd,
+                      off_t offset);
+static void sys_munmap(void *addr);
+static int sys_msync(void *addr, size_t length);
+static int sys_madvise(void *addr, size_t length, int advice);
+#endif
+
 /* System call.
  *
  * Previously system call services was handled by the interrupt handler
@@ -29,6 +45,8 @@ void syscall_handler(struct intr_frame *);
 #define MSR_LSTAR 0xc0000082        /* Long mode SYSCALL target */
 #define MSR_SYSCALL_MASK 0xc0000084 /* Mask for the eflags */
 
+struct kmem_cache *fd_elem_cachep; /* added for slab allocator */
+
 static struct file *convert_fd_to_file(int fd) {
   struct list_elem *e;
   struct thread *cur_thread = thread_current();
@@ -55,7 +73,14 @@ void syscall_init(void) {
 
   /* --------------- added for PROJECT.2-2 --------------- */
 
-  lock_init(&filesys_lock); /* read(), write()시에 동기화 문제를 위한 lock  */
+  /* ------- before per-inode locking -------
+  lock_init(&filesys_lock); */
+
+  /* added for slab allocator */
+  fd_elem_cachep =
+      kmem_cache_create("fd_elem", sizeof(struct fd_elem), 0, NULL);
+  if (fd_elem_cachep == NULL)
+    PANIC("syscall_init: cannot create object cache");
 
   /* ----------------------------------------------------- */
 }
@@ -134,6 +159,27 @@ void syscall_handler(struct intr_frame *f UNUSED) {
       do_close(f->R.rdi);
       break;
 
+#ifdef VM
+    /* ----------------- added for mmap ----------------- */
+
+    case SYS_MMAP: /* void *addr, size_t length, int writable, int fd, off_t offset */
+      f->R.rax = (uint64_t)sys_mmap((void *)f->R.rdi, f->R.rsi, f->R.rdx,
+                                    f->R.r10, f->R.r8);
+      break;
+
+    case SYS_MUNMAP: /* void *addr */
+      sys_munmap((void *)f->R.rdi);
+      break;
+
+    case SYS_MSYNC: /* void *addr, size_t length */
+      f->R.rax = sys_msync((void *)f->R.rdi, f->R.rsi);
+      break;
+
+    case SYS_MADVISE: /* void *addr, size_t length, int advice */
+      f->R.rax = sys_madvise((void *)f->R.rdi, f->R.rsi, f->R.rdx);
+      break;
+#endif
+
       // case SYS_DUP2: /* int oldfd, int newfd */
       //   dup2(f->R.rdi, f->R.rsi);
       //   break;
@@ -163,7 +209,9 @@ void validate_adress(const void *addr) {
   if (addr == NULL) do_exit(-1);
   if (is_kernel_vaddr(addr)) do_exit(-1);
 
-  if (pml4_get_page(curr_t->pml4, addr) == NULL) do_exit(-1);
+  /* ------- before swap -------
+     swap out된 page는 pml4에 없지만 spt에 있으므로 유효한 주소다.
+  if (pml4_get_page(curr_t->pml4, addr) == NULL) do_exit(-1); */
 
     /* ----------------- added for PROJECT.3-3 ----------------- */
 
@@ -172,7 +220,9 @@ void validate_adress(const void *addr) {
   struct page *page = NULL;
 
   page = spt_find_page(&curr_t->spt, pg_start_ptr);
-  if (page == NULL) do_exit(-1);
+  /* added for VMA : 아직 page가 없어도 area 안의 주소는 유효하다. */
+  if (page == NULL && spt_find_area(&curr_t->spt, pg_start_ptr) == NULL)
+    do_exit(-1);
 
 #else
   /* ------------------ until PROJECT.2-2 ------------------ */
@@ -190,6 +240,12 @@ void check_valid_buffer(void *buffer) {
   page = spt_find_page(&thread_current()->spt, pg_start_ptr);
 
   if (page != NULL && page->writable == false) do_exit(-1);
+
+  /* added for VMA */
+  if (page == NULL) {
+    struct vm_area *area = spt_find_area(&thread_current()->spt, pg_start_ptr);
+    if (area != NULL && area->writable == false) do_exit(-1);
+  }
 }
 
 /**
@@ -227,9 +283,7 @@ bool do_create(const char *file, unsigned initial_size) {
 
   validate_adress(file);
 
-  lock_acquire(&filesys_lock);
   success = filesys_create(file, initial_size);
-  lock_release(&filesys_lock);
 
   return success ? true : false;
 }
@@ -245,9 +299,7 @@ bool do_remove(const char *file) {
 
   validate_adress(file);
 
-  lock_acquire(&filesys_lock);
   succ = filesys_remove(file);
-  lock_release(&filesys_lock);
 
   return succ;
 }
@@ -261,16 +313,14 @@ int do_open(const char *file) {
   validate_adress(file);
 
   struct thread *cur_thread = thread_current();
-  lock_acquire(&filesys_lock);
   struct file *file_ptr = filesys_open(file);
-  lock_release(&filesys_lock);
   if (!file_ptr) {
     return -1;
   }
   // if (!strcmp(file, cur_thread->name)) {
   //   file_deny_write(file_ptr);
   // }
-  struct fd_elem *file_elem = (struct fd_elem *)malloc(sizeof(struct fd_elem));
+  struct fd_elem *file_elem = kmem_cache_alloc(fd_elem_cachep);
   file_elem->fd = cur_thread->next_fd++;
   file_elem->file_ptr = file_ptr;
   list_push_back(&cur_thread->fdt, &file_elem->elem);
@@ -304,6 +354,79 @@ int do_filesize(int fd) {
   return ret;
 }
 
+/**
+ * @brief 현재 thread의 bounce page를 반환한다. (added for per-inode rwlock)
+ * 
+ * @details 처음 read()/write() 할 때 한 번만 할당하고, 이후 호출은 같은 page를
+ *          재사용한다. process_exit()에서 해제한다.
+ * 
+ * @return bounce page, 할당에 실패하면 NULL
+*/
+static uint8_t *io_buffer(void) {
+  struct thread *curr_t = thread_current();
+
+  if (curr_t->io_buf == NULL) curr_t->io_buf = palloc_get_page(0);
+  return curr_t->io_buf;
+}
+
+/**
+ * @brief FILE에서 LENGTH byte를 user BUFFER로 읽는다. (added for per-inode rwlock)
+ * 
+ * @details inode_read_at()은 inode의 rwlock을 잡고 buffer에 쓴다. user
+ *          buffer에 바로 쓰면 그 안에서 page fault가 나고, fault 처리
+ *          (lazy load, mmap page-in, dirty mmap page의 write-back)가 같은
+ *          inode나 다른 inode의 rwlock을 잡으려다 deadlock이 날 수 있다.
+ *          그래서 한 page씩 thread의 bounce page로 읽은 뒤, lock을 놓은 상태에서
+ *          user buffer로 복사한다.
+ * 
+ * @return 읽은 byte 수, bounce page를 얻지 못하면 -1
+*/
+static int file_read_user(struct file *file, void *buffer, unsigned length) {
+  uint8_t *bounce = io_buffer();
+  unsigned done = 0;
+
+  if (bounce == NULL) return -1;
+
+  while (done < length) {
+    unsigned chunk = length - done < PGSIZE ? length - done : PGSIZE;
+    off_t n = file_read(file, bounce, chunk);
+
+    memcpy(buffer + done, bounce, n); /* page fault가 나도 된다 */
+    done += n;
+    if ((unsigned)n < chunk) break;
+  }
+
+  return done;
+}
+
+/**
+ * @brief user BUFFER의 LENGTH byte를 FILE에 쓴다. (added for per-inode rwlock)
+ * 
+ * @details file_read_user()처럼 inode의 rwlock 밖에서 user buffer를 thread의
+ *          bounce page로 먼저 복사한다.
+ * 
+ * @return 쓴 byte 수, bounce page를 얻지 못하면 -1
+*/
+static int file_write_user(struct file *file, const void *buffer,
+                           unsigned length) {
+  uint8_t *bounce = io_buffer();
+  unsigned done = 0;
+
+  if (bounce == NULL) return -1;
+
+  while (done < length) {
+    unsigned chunk = length - done < PGSIZE ? length - done : PGSIZE;
+    off_t n;
+
+    memcpy(bounce, buffer + done, chunk); /* page fault가 나도 된다 */
+    n = file_write(file, bounce, chunk);
+    done += n;
+    if ((unsigned)n < chunk) break;
+  }
+
+  return done;
+}
+
 /**
  * @brief fd에 해당하는 file에서 length만큼 읽어 buffer에 저장한다.
  * 
@@ -361,9 +484,9 @@ int do_read(int fd, void *buffer, unsigned length) {
   file_p = convert_fd_to_file(fd);
   if (!file_p) return -1;
 
-  lock_acquire(&filesys_lock);
-  read_bytes = file_read(file_p, buffer, length);
-  lock_release(&filesys_lock);
+  /* ------- before per-inode rwlock -------
+  read_bytes = file_read(file_p, buffer, length); */
+  read_bytes = file_read_user(file_p, buffer, length);
 
   return read_bytes;
 }
@@ -399,31 +522,26 @@ int do_write(int fd, const void *buffer, unsigned length) {
     return -1;
   }
 
-  lock_acquire(&filesys_lock);
-
   if (fd == STDOUT_FILENO) {
     putbuf(buffer, length);
     write_bytes = length;
   } else {
     file_p = convert_fd_to_file(fd);
 
-    if (!file_p) {
-      lock_release(&filesys_lock);
-      return -1;
-    }
+    if (!file_p) return -1;
 
-    write_bytes = file_write(file_p, buffer, length);
+    /* ------- before per-inode rwlock -------
+    write_bytes = file_write(file_p, buffer, length); */
+    write_bytes = file_write_user(file_p, buffer, length);
   }
 
-  lock_release(&filesys_lock);
-
   return write_bytes;
 }
 
 void do_close(int fd) {
   struct thread *cur_thread = thread_current();
   struct list_elem *e;
-  struct fd_elem *file_elem;
+  struct fd_elem *file_elem = NULL;
   for (e = list_begin(&cur_thread->fdt); e != list_end(&cur_thread->fdt);
        e = list_next(e)) {
     file_elem = list_entry(e, struct fd_elem, elem);
@@ -435,10 +553,8 @@ void do_close(int fd) {
     do_exit(-1);
   }
   list_remove(e);
-  lock_acquire(&filesys_lock);
   file_close(file_elem->file_ptr);
-  lock_release(&filesys_lock);
-  free(file_elem);
+  kmem_cache_free(fd_elem_cachep, file_elem);
 }
 
 /**
@@ -451,15 +567,13 @@ void do_seek(int fd, unsigned position) {
   struct thread *curr = thread_current();
   struct file *file;
 
-  if (fd < 2) return NULL;
+  if (fd < 2) return;
 
   file = convert_fd_to_file(fd);
 
-  if (!file) return NULL;
+  if (!file) return;
 
-  lock_acquire(&filesys_lock);
   file_seek(file, position);
-  lock_release(&filesys_lock);
 }
 
 unsigned do_tell(int fd) {
@@ -470,9 +584,7 @@ unsigned do_tell(int fd) {
 
   if (!file) return -1;
 
-  lock_acquire(&filesys_lock);
   position = file_tell(file);
-  lock_release(&filesys_lock);
 
   if (position < 0) return -1;
 
@@ -494,7 +606,7 @@ pid_t do_fork(const char *thread_name) {
     return TID_ERROR;
   }
 
-  struct thread *child_thread;
+  struct thread *child_thread = NULL;
   struct list_elem *e;
   for (e = list_begin(&t->child_list); e != list_end(&t->child_list);
        e = list_next(e)) {
@@ -528,4 +640,56 @@ int do_exec(const char *cmd_line) {
 
 int do_wait(pid_t pid) { return process_wait(pid); }
 
-/* --------------------------------------------------------- */
\ No newline at end of file
+/* --------------------------------------------------------- */
+
+#ifdef VM
+/* ----------------- added for mmap ----------------- */
+
+/**
+ * @brief fd로 연 file의 OFFSET부터 LENGTH byte를 ADDR에 매핑한다.
+ * 
+ * @return ADDR, 실패하면 MAP_FAILED
+ * 
+ * @details ADDR과 OFFSET이 page 경계가 아니거나, LENGTH가 0이거나, 범위가
+ *          kernel 영역을 포함하거나, fd가 console이면 실패한다.
+ *          나머지 검사(겹치는 mapping, 빈 file)는 do_mmap()이 한다.
+*/
+static void *sys_mmap(void *addr, size_t length, int writable, int fd,
+                      off_t offset) {
+  struct file *file;
+
+  if (addr == NULL || pg_ofs(addr) != 0 || length == 0) return MAP_FAILED;
+  if (offset < 0 || offset % PGSIZE != 0) return MAP_FAILED;
+  if (addr + length < addr || is_kernel_vaddr(addr) ||
+      is_kernel_vaddr(addr + length - 1))
+    return MAP_FAILED;
+  if (fd == STDIN_FILENO || fd == STDOUT_FILENO) return MAP_FAILED;
+
+  file = convert_fd_to_file(fd);
+  if (file == NULL) return MAP_FAILED;
+
+  return do_mmap(addr, length, writable, file, offset);
+}
+
+/* ADDR에서 시작하는 mapping을 해제한다. */
+static void sys_munmap(void *addr) { do_munmap(addr); }
+
+/**
+ * @brief [ADDR, ADDR + LENGTH)의 mapping 중 수정된 page를 file에 쓴다.
+ * 
+ * @return 성공하면 0, 범위가 mapping 밖이면 -1
+*/
+static int sys_msync(void *addr, size_t length) {
+  if (addr + length < addr || is_kernel_vaddr(addr)) return -1;
+
+  return do_msync(addr, length) ? 0 : -1;
+}
+
+/* added for madvise */
+static int sys_madvise(void *addr, size_t length, int advice) {
+  if (addr + length < addr || is_kernel_vaddr(addr)) return -1;
+  if (advice < MADV_NORMAL || advice > MADV_DONTNEED) return -1;
+
+  return vm_advise(addr, length, advice) ? 0 : -1;
+}
+#endif
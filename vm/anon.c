@@ -1,6 +1,13 @@
 /* anon.c: Implementation of page for non-disk image (a.k.a. anonymous page). */
 
+#include <bitmap.h>
+#include <stdio.h>
 #include "devices/disk.h"
+#include "devices/timer.h"
+#include "threads/malloc.h"
+#include "threads/slab.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
 #include "vm/vm.h"
 
 /* DO NOT MODIFY BELOW LINE */
@@ -17,10 +24,110 @@ static const struct page_operations anon_ops = {
     .type = VM_ANON,
 };
 
-/* Initialize the data for anonymous pages */
+/* ----------------- added for swap ----------------- */
+
+/* page 하나를 저장하는 slot의 sector 수 */
+#define SECTORS_PER_SLOT (PGSIZE / DISK_SECTOR_SIZE)
+
+/* swap slot의 사용 여부 (true면 사용중)와 이를 보호하는 lock */
+static struct bitmap *swap_table;
+static struct lock swap_lock;
+
+/* added for copy-on-write : slot마다 그 slot을 가리키는 page 수.
+   fork()한 process들은 swap out된 page의 slot을 공유한다. */
+static unsigned short *swap_refs;
+
+/* Statistics. */
+static long long swap_out_cnt;   /* swap out한 page 수 */
+static long long swap_in_cnt;    /* swap in한 page 수 */
+static long long swap_write_cnt; /* swap out에 사용한 disk command 수 */
+static int64_t swap_out_ticks;   /* swap out에 걸린 timer tick */
+static int64_t swap_in_ticks;    /* swap in에 걸린 timer tick */
+
+static size_t swap_alloc(size_t cnt);
+static void swap_free(size_t slot);
+static bool anon_read_swapped(struct page *page, void *kva);
+
+/* -------------------------------------------------- */
+
+/**
+ * @brief anonymous page를 위한 swap disk를 준비한다.
+ * 
+ * @details swap disk는 1:1 (channel 1의 slave)이다. disk를 page 크기의
+ *          slot으로 나누고, 빈 slot을 bitmap으로 관리한다. swap disk가 없으면
+ *          slot이 0개인 bitmap을 만들어 swap out이 항상 실패하도록 한다.
+ * 
+ * @note Initialize the data for anonymous pages
+*/
 void vm_anon_init(void) {
   /* TODO: Set up the swap_disk. */
-  swap_disk = NULL;
+  size_t slot_cnt = 0;
+
+  /* ------- before swap -------
+  swap_disk = NULL; */
+  swap_disk = disk_get(1, 1);
+  if (swap_disk != NULL) slot_cnt = disk_size(swap_disk) / SECTORS_PER_SLOT;
+
+  swap_table = bitmap_create(slot_cnt);
+  swap_refs = calloc(slot_cnt + 1, sizeof *swap_refs);
+  if (swap_table == NULL || swap_refs == NULL)
+    PANIC("vm_anon_init: cannot create swap table");
+  lock_init(&swap_lock);
+}
+
+/**
+ * @brief 연속된 빈 slot CNT개를 찾아 사용중으로 표시한다.
+ * 
+ * @return 첫 slot의 번호, 연속된 빈 slot이 없으면 SWAP_SLOT_NONE
+*/
+static size_t swap_alloc(size_t cnt) {
+  size_t slot;
+
+  lock_acquire(&swap_lock);
+  slot = bitmap_scan_and_flip(swap_table, 0, cnt, false);
+  lock_release(&swap_lock);
+
+  return slot == BITMAP_ERROR ? SWAP_SLOT_NONE : slot;
+}
+
+/* SLOT을 가리키는 page가 하나 줄었다. 마지막 page였으면 빈 slot으로 되돌린다. */
+static void swap_free(size_t slot) {
+  lock_acquire(&swap_lock);
+  ASSERT(bitmap_test(swap_table, slot));
+  ASSERT(swap_refs[slot] > 0);
+  if (--swap_refs[slot] == 0) bitmap_reset(swap_table, slot);
+  lock_release(&swap_lock);
+}
+
+/**
+ * @brief swap out된 SRC page의 slot을 DST page도 가리키게 한다.
+ * 
+ * @details fork()에서 swap out된 부모 page를 disk I/O 없이 복사할 때 쓴다.
+ *          먼저 swap in하는 쪽이 slot을 읽어 자신만의 frame을 받는다.
+*/
+void anon_swap_dup(struct page *dst, struct page *src) {
+  size_t slot = src->anon.swap_slot;
+
+  dst->anon.swap_slot = slot;
+  if (slot == SWAP_SLOT_NONE) return;
+
+  lock_acquire(&swap_lock);
+  ASSERT(bitmap_test(swap_table, slot));
+  swap_refs[slot]++;
+  lock_release(&swap_lock);
+}
+
+/* Prints swap statistics. */
+void swap_print_stats(void) {
+  printf("Swap: %zu of %zu slots in use, %lld pages out in %lld writes, "
+         "%lld pages in\n",
+         bitmap_count(swap_table, 0, bitmap_size(swap_table), true),
+         bitmap_size(swap_table), swap_out_cnt, swap_write_cnt, swap_in_cnt);
+  if (swap_out_ticks > 0)
+    printf("Swap: %lld pages/s out\n",
+           swap_out_cnt * TIMER_FREQ / swap_out_ticks);
+  if (swap_in_ticks > 0)
+    printf("Swap: %lld pages/s in\n", swap_in_cnt * TIMER_FREQ / swap_in_ticks);
 }
 
 /* Initialize the file mapping */
@@ -29,19 +136,91 @@ bool anon_initializer(struct page *page, enum vm_type type, void *kva) {
   page->operations = &anon_ops;
   struct anon_page *anon_page = &page->anon;
 
+  anon_page->swap_slot = SWAP_SLOT_NONE; /* added for swap */
+
   return true;
 }
 
-/* Swap in the page by read contents from the swap disk. */
+/* swap slot에 저장된 page의 내용을 KVA로 읽어온다. slot은 그대로 둔다. */
+static bool anon_read_swapped(struct page *page, void *kva) {
+  struct anon_page *anon_page = &page->anon;
+  int64_t start = timer_ticks();
+
+  if (anon_page->swap_slot == SWAP_SLOT_NONE) return false;
+
+  disk_read_multiple(swap_disk, anon_page->swap_slot * SECTORS_PER_SLOT,
+                     SECTORS_PER_SLOT, kva);
+
+  swap_in_ticks += timer_elapsed(start);
+  swap_in_cnt++;
+  return true;
+}
+
+/**
+ * @brief swap disk에서 page를 읽어오고 slot을 해제한다.
+ * 
+ * @note Swap in the page by read contents from the swap disk.
+*/
 static bool anon_swap_in(struct page *page, void *kva) {
   struct anon_page *anon_page = &page->anon;
 
+  if (!anon_read_swapped(page, kva)) return false;
+
+  swap_free(anon_page->swap_slot);
+  anon_page->swap_slot = SWAP_SLOT_NONE;
+
   return true;
 }
 
-/* Swap out the page by writing contents to the swap disk. */
+/**
+ * @brief FRAMES의 CNT개 frame을 연속된 slot에 한 번의 disk command로 쓴다.
+ * 
+ * @details eviction은 victim 여러 개를 모아서 이 함수를 호출한다. 연속된 slot
+ *          CNT개가 없으면 실패하고, 호출자는 더 적은 수로 다시 시도할 수 있다.
+ *          frame은 모두 anon page의 frame이고 매핑이 지워진 상태여야 한다.
+ *          frame을 공유하는 page들은 모두 같은 slot을 가리킨다.
+ * 
+ * @return 성공하면 true
+*/
+bool anon_swap_out_cluster(struct frame *frames[], size_t cnt) {
+  const void *bufs[SWAP_CLUSTER];
+  int64_t start;
+  size_t slot, i;
+
+  ASSERT(cnt > 0 && cnt <= SWAP_CLUSTER);
+
+  slot = swap_alloc(cnt);
+  if (slot == SWAP_SLOT_NONE) return false;
+
+  start = timer_ticks();
+  for (i = 0; i < cnt; i++) {
+    struct list_elem *e;
+
+    bufs[i] = frames[i]->kva;
+    for (e = list_begin(&frames[i]->mappings);
+         e != list_end(&frames[i]->mappings); e = list_next(e)) {
+      struct page *page = list_entry(e, struct page, mapping_elem);
+
+      page->anon.swap_slot = slot + i;
+      swap_refs[slot + i]++;
+    }
+  }
+  disk_write_gather(swap_disk, slot * SECTORS_PER_SLOT, bufs, cnt,
+                    SECTORS_PER_SLOT);
+
+  swap_out_ticks += timer_elapsed(start);
+  swap_out_cnt += cnt;
+  swap_write_cnt++;
+  return true;
+}
+
+/**
+ * @brief page를 swap disk의 빈 slot에 쓴다.
+ * 
+ * @note Swap out the page by writing contents to the swap disk.
+*/
 static bool anon_swap_out(struct page *page) {
-  struct anon_page *anon_page = &page->anon;
+  return anon_swap_out_cluster(&page->frame, 1);
 }
 
 /**
@@ -52,9 +231,18 @@ static bool anon_swap_out(struct page *page) {
 */
 static void anon_destroy(struct page *page) {
   struct anon_page *anon_page = &page->anon;
+
+  /* ------- before frame table -------
   struct frame *frame = page->frame;
 
-  if (frame != NULL) free(frame);
+  if (frame != NULL) kmem_cache_free(frame_cachep, frame);
+
+  page->frame = NULL; */
+  vm_free_frame(page);
 
-  page->frame = NULL;
+  /* added for swap */
+  if (anon_page->swap_slot != SWAP_SLOT_NONE) {
+    swap_free(anon_page->swap_slot);
+    anon_page->swap_slot = SWAP_SLOT_NONE;
+  }
 }
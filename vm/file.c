@@ -1,6 +1,12 @@
 /* file.c: Implementation of memory backed file object (mmaped object). */
 
 #include "vm/vm.h"
+#include <round.h>
+#include <stdio.h>
+#include <string.h>
+#include "threads/mmu.h"
+#include "threads/slab.h"
+#include "threads/vaddr.h"
 
 static bool file_backed_swap_in(struct page *page, void *kva);
 static bool file_backed_swap_out(struct page *page);
@@ -14,35 +20,194 @@ static const struct page_operations file_ops = {
     .type = VM_FILE,
 };
 
+struct kmem_cache *file_segment_cachep; /* added for slab allocator */
+
+/* ----------------- added for mmap ----------------- */
+
+static long long write_back_cnt; /* file에 쓴 수정된 page 수 */
+static long long clean_cnt;      /* 수정되지 않아 쓰지 않은 page 수 */
+
 /* The initializer of file vm */
-void vm_file_init(void) {}
+void vm_file_init(void) {
+  file_segment_cachep = kmem_cache_create(
+      "file_segment_info", sizeof(struct file_segment_info), 0, NULL);
+  if (file_segment_cachep == NULL)
+    PANIC("vm_file_init: cannot create object cache");
+}
 
 /* Initialize the file backed page */
+/**
+ * @brief uninit page를 file page로 초기화한다.
+ * 
+ * @details uninit page의 aux(struct file_segment_info)에서 file과 위치를 가져온다.
+ *          aux는 page->file과 같은 union에 있으므로 덮어쓰기 전에 읽어야 한다.
+ *          aux의 file은 init(lazy_load_segment())이 닫으므로 duplicate해서 가진다.
+ *          내용은 init이 채운다.
+*/
 bool file_backed_initializer(struct page *page, enum vm_type type, void *kva) {
+  struct file_segment_info *aux = page->uninit.aux;
+
   /* Set up the handler */
   page->operations = &file_ops;
 
   struct file_page *file_page = &page->file;
+
+  /* added for shared text */
+  file_page->file = file_duplicate(aux->file);
+  file_page->offset = aux->offset;
+  file_page->read_bytes = aux->read_bytes;
+  file_page->zero_bytes = aux->zero_bytes;
+
+  return file_page->file != NULL;
 }
 
 /* Swap in the page by read contents from the file. */
 static bool file_backed_swap_in(struct page *page, void *kva) {
   struct file_page *file_page UNUSED = &page->file;
+
+  /* added for shared text */
+  if (file_page->file == NULL ||
+      file_read_at(file_page->file, kva, file_page->read_bytes,
+                   file_page->offset) != (off_t)file_page->read_bytes)
+    return false;
+  memset(kva + file_page->read_bytes, 0, file_page->zero_bytes);
+
+  return true;
 }
 
 /* Swap out the page by writeback contents to the file. */
+/**
+ * @brief file page의 수정된 내용을 file에 쓴다.
+ * 
+ * @details PTE의 dirty bit이 켜진 page만 쓰고 dirty bit을 끈다. 수정되지 않은
+ *          page(읽기 전용 page 포함)의 내용은 file에 그대로 있으므로 쓸 것이
+ *          없다. 다음 page fault에서 file_backed_swap_in()으로 다시 읽는다.
+ *          evict할 때는 PTE를 지운 뒤에 부르는데, pml4_clear_page()는
+ *          dirty bit을 남겨둔다.
+ * 
+ * @warning frame을 pin하고 frame_lock은 놓은 채로 호출해야 한다.
+ *          (vm_evict_frame(), vm_sync_page() 참고)
+*/
 static bool file_backed_swap_out(struct page *page) {
   struct file_page *file_page UNUSED = &page->file;
+  uint64_t *pml4 = page->owner->pml4;
+
+  if (!pml4_is_dirty(pml4, page->va)) {
+    clean_cnt++;
+    return true;
+  }
+
+  if (file_write_at(file_page->file, page->frame->kva, file_page->read_bytes,
+                    file_page->offset) != (off_t)file_page->read_bytes)
+    return false;
+
+  pml4_set_dirty(pml4, page->va, false);
+  write_back_cnt++;
+  return true;
 }
 
 /* Destory the file backed page. PAGE will be freed by the caller. */
 static void file_backed_destroy(struct page *page) {
   struct file_page *file_page UNUSED = &page->file;
+
+  vm_sync_page(page);          /* added for mmap */
+  vm_free_frame(page);         /* added for frame table */
+  file_close(file_page->file); /* added for shared text */
+}
+
+/* mmap한 page를 처음 접근할 때 file에서 읽는다. (uninit page의 init) */
+static bool lazy_load_file(struct page *page, void *aux) {
+  struct file_segment_info *info = aux;
+  bool succ = file_backed_swap_in(page, page->frame->kva);
+
+  file_close(info->file);
+  kmem_cache_free(file_segment_cachep, info);
+
+  return succ;
 }
 
 /* Do the mmap */
+/**
+ * @brief FILE의 OFFSET부터 LENGTH byte를 ADDR에 매핑한다.
+ * 
+ * @details area 하나만 등록하고 page는 처음 접근할 때 file에서 읽는다.
+ *          file 끝을 넘는 부분은 0으로 채우고 file에 쓰지 않는다.
+ *          FILE은 duplicate해서 가지므로 호출자가 닫아도 된다.
+ *          인자 검사는 호출자(syscall)가 한다.
+ * 
+ * @return ADDR. 이미 매핑된 주소와 겹치거나 file이 비어있으면 NULL
+*/
 void *do_mmap(void *addr, size_t length, int writable, struct file *file,
-              off_t offset) {}
+              off_t offset) {
+  struct supplemental_page_table *spt = &thread_current()->spt;
+  off_t file_len = file_length(file);
+  size_t read_bytes = 0;
+  struct vm_area *area;
+  void *va;
+
+  if (file_len == 0) return NULL;
+  if (offset < file_len)
+    read_bytes = (size_t)(file_len - offset) < length
+                     ? (size_t)(file_len - offset)
+                     : length;
+
+  /* area에 속하지 않는 page(stack)와도 겹치면 안된다. */
+  length = ROUND_UP(length, PGSIZE);
+  for (va = addr; va < addr + length; va += PGSIZE)
+    if (spt_find_page(spt, va) != NULL) return NULL;
+
+  area = vm_map_area(addr, length, writable, VM_FILE, file, offset,
+                     read_bytes, lazy_load_file);
+  if (area == NULL) return NULL;
+
+  area->mmap = true;
+  return addr;
+}
 
 /* Do the munmap */
-void do_munmap(void *addr) {}
+/**
+ * @brief ADDR에서 시작하는 mmap을 해제한다. 수정된 page는 file에 쓴다.
+ *        ADDR이 mmap의 시작 주소가 아니면 아무것도 하지 않는다.
+*/
+void do_munmap(void *addr) {
+  struct vm_area *area = spt_find_area(&thread_current()->spt, addr);
+
+  if (area == NULL || !area->mmap || area->start != addr) return;
+
+  vm_unmap_area(area);
+}
+
+/**
+ * @brief [ADDR, ADDR + LENGTH)의 mmap page 중 수정된 page를 file에 쓴다.
+ * 
+ * @details page는 매핑된 채로 남는다. frame에 없는 page는 evict할 때 이미
+ *          썼으므로 건너뛴다.
+ * 
+ * @return ADDR이 page 경계가 아니거나 범위가 mmap 밖을 포함하면 false
+*/
+bool do_msync(void *addr, size_t length) {
+  struct supplemental_page_table *spt = &thread_current()->spt;
+  void *va;
+
+  if (pg_ofs(addr) != 0) return false;
+
+  for (va = addr; va < addr + length; va += PGSIZE) {
+    struct vm_area *area = spt_find_area(spt, va);
+    struct page *page;
+
+    if (area == NULL || !area->mmap) return false;
+
+    page = spt_find_page(spt, va);
+    if (page != NULL && VM_TYPE(page->operations->type) == VM_FILE &&
+        !vm_sync_page(page))
+      return false;
+  }
+
+  return true;
+}
+
+/* Prints file-backed page statistics. */
+void file_print_stats(void) {
+  printf("Mmap: %lld dirty pages written back, %lld clean pages skipped\n",
+         write_back_cnt, clean_cnt);
+}
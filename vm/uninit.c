@@ -18,6 +18,7 @@
 // clang-format off
 #include "vm/vm.h"
 #include "vm/uninit.h"
+#include "threads/slab.h"
 // clang-format on
 
 static bool uninit_initialize(struct page *page, void *kva);
@@ -101,6 +102,12 @@ static void uninit_destroy(struct page *page) {
 
   /* TODO: Fill this function.
 	 * TODO: If you don't have anything to do, just return. */
-  if (uninit->aux != NULL) free(aux);
-  // TODO : file_duplicate 했을시에 file_close()
+  /* added for VMA : aux가 가진 duplicate file도 닫는다. */
+  if (uninit->aux != NULL) {
+    file_close(aux->file);
+    kmem_cache_free(file_segment_cachep, aux);
+  }
+
+  /* added for frame table : lazy load에 실패한 page는 frame을 들고 있을 수 있다. */
+  vm_free_frame(page);
 }
@@ -1,13 +1,79 @@
 /* vm.c: Generic interface for virtual memory objects. */
 
 #include "vm/vm.h"
+#include <round.h>
+#include <stdio.h>
+#include <string.h>
 #include "hash.h"
 #include "include/threads/vaddr.h"
 #include "include/vm/anon.h"
 #include "include/vm/file.h"
 #include "threads/malloc.h"
+#include "threads/mmu.h"
+#include "threads/slab.h"
+#include "threads/synch.h"
 #include "vm/inspect.h"
 
+/* ----------------- added for slab allocator ----------------- */
+
+struct kmem_cache *page_cachep;
+struct kmem_cache *frame_cachep;
+struct kmem_cache *area_cachep; /* added for VMA */
+
+/* ----------------- added for frame table ----------------- */
+
+/* user pool에서 할당한 모든 frame의 list와 이를 보호하는 lock.
+   clock_hand는 다음에 eviction 후보로 검사할 frame을 가리킨다. */
+static struct list frame_table;
+static struct lock frame_lock;
+static struct condition writeback_cond; /* added for mmap : page_frame() 참고 */
+static struct list_elem *clock_hand;
+static long long evict_cnt; /* evict한 page 수 */
+static long long cow_cnt;   /* copy-on-write로 복사한 page 수 */
+
+/* ----------------- added for fault-around ----------------- */
+
+/* lazy load되는 segment에서 page fault가 나면 그 page부터 최대 이만큼의 page를
+   한 번의 file read로 채운다. 1이면 fault-around를 하지 않는다.
+   커널 옵션 -fault-around=N으로 바꿀 수 있다. */
+unsigned vm_fault_around = VM_FAULT_AROUND_DEFAULT;
+
+static long long fault_cnt;        /* 처리한 page fault 수 */
+static long long fault_around_cnt; /* fault-around로 미리 채운 page 수 */
+
+/* ----------------- added for VMA ----------------- */
+
+/* 살아있는 struct page, struct vm_area의 수와 그 최댓값 */
+static long long page_cnt, page_peak;
+static long long area_cnt, area_peak;
+
+/* ----------------- added for shared text ----------------- */
+
+/* 읽기 전용 file page를 담고 있는 frame을 (inode, offset)으로 찾는 table.
+   같은 실행 파일을 실행하는 process들은 text page를 이 frame들로 공유한다.
+   frame_lock이 보호한다. */
+static struct hash text_cache;
+static long long text_hit_cnt; /* text_cache에서 찾아 매핑한 page 수 */
+static size_t frame_cnt, frame_peak; /* 할당한 user frame 수와 그 최댓값 */
+
+/* ----------------- added for zero page ----------------- */
+
+/* 0으로 채워진 frame 하나. 아직 쓰지 않은 zero-fill page를 읽으면 이 frame을
+   읽기 전용으로 매핑하고, 처음 쓸 때 vm_handle_wp()가 새 frame을 준다.
+   frame_table에 넣지 않고 항상 pinned이므로 evict되거나 해제되지 않는다. */
+static struct frame *zero_frame;
+static long long zero_map_cnt;   /* zero_frame을 매핑한 read fault 수 */
+static long long zero_break_cnt; /* zero_frame에서 새 frame으로 옮긴 page 수 */
+
+/* ----------------- added for madvise ----------------- */
+
+static long long prefetch_cnt; /* WILLNEED로 미리 읽어온 page 수 */
+static long long release_cnt;  /* DONTNEED와 drop-behind로 해제한 page 수 */
+
+static uint64_t text_cache_hash(const struct hash_elem *e, void *aux);
+static bool text_cache_less(const struct hash_elem *a,
+                            const struct hash_elem *b, void *aux);
+
 /**
  * @brief 각 하위 시스템의 초기화 코드를 호출하여 가상 메모리 하위 시스템을 초기화합니다.
  * 
@@ -23,6 +89,33 @@ void vm_init(void) {
   register_inspect_intr();
   /* DO NOT MODIFY UPPER LINES. */
   /* TODO: Your code goes here. */
+
+  /* ----------------- added for slab allocator -----------------
+     malloc()은 struct page를 2의 거듭제곱 크기로 올려 할당해 메모리를
+     낭비하고, 모든 같은 크기의 할당이 하나의 lock을 공유한다. */
+  page_cachep = kmem_cache_create("page", sizeof(struct page), 0, NULL);
+  frame_cachep = kmem_cache_create("frame", sizeof(struct frame), 0, NULL);
+  area_cachep = kmem_cache_create("vm_area", sizeof(struct vm_area), 0, NULL);
+  if (page_cachep == NULL || frame_cachep == NULL || area_cachep == NULL)
+    PANIC("vm_init: cannot create object caches");
+
+  /* added for frame table */
+  list_init(&frame_table);
+  lock_init(&frame_lock);
+  cond_init(&writeback_cond); /* added for mmap */
+  clock_hand = NULL;
+
+  /* added for shared text */
+  if (!hash_init(&text_cache, text_cache_hash, text_cache_less, NULL))
+    PANIC("vm_init: cannot create text cache");
+
+  /* added for zero page : user pool을 쓰지 않도록 kernel pool에서 받는다. */
+  zero_frame = kmem_cache_zalloc(frame_cachep);
+  if (zero_frame == NULL ||
+      (zero_frame->kva = palloc_get_page(PAL_ZERO)) == NULL)
+    PANIC("vm_init: cannot allocate the zero frame");
+  list_init(&zero_frame->mappings);
+  zero_frame->pinned = true;
 }
 
 /**
@@ -47,9 +140,22 @@ enum vm_type page_get_type(struct page *page) {
 
 /* Helpers */
 static struct frame *vm_get_victim(void);
+static struct frame *frame_alloc(bool evict);
+static bool is_lazy_segment(struct page *page);
+static size_t vm_claim_segment(struct page *page, size_t want, bool streamed);
 static bool vm_do_claim_page(struct page *page);
 static struct frame *vm_evict_frame(void);
 static struct page *page_lookup(struct hash *hash_table, const void *address);
+static struct page *area_new_page(struct vm_area *area, void *va);
+static bool text_cache_map(struct page *page);
+static bool zero_fill_page(struct page *page, void *aux);
+static bool vm_map_zero(struct page *page);
+static bool vm_claim_advised(struct page *page);
+static bool text_cached(struct page *page);
+static void frame_cache(struct frame *frame, struct page *page);
+static void frame_uncache(struct frame *frame);
+static struct frame *page_frame(struct page *page);
+static void writeback_done(struct frame *frame);
 static void supplemental_page_destroy(struct hash_elem *e, void *aux UNUSED);
 
 /**
@@ -94,7 +200,9 @@ bool vm_alloc_page_with_initializer(enum vm_type type, void *upage,
      * >  uninit_new를 호출하여 "uninit"페이지 구조체를 만듭니다.
      * >  uninit_new를 호출한 후 필드를 수정해야합니다. */
 
-    struct page *page = (struct page *)calloc(1, sizeof(struct page));
+    /* ------- before slab allocator -------
+    struct page *page = (struct page *)calloc(1, sizeof(struct page)); */
+    struct page *page = kmem_cache_zalloc(page_cachep);
     if (!page) goto err;
 
     switch (VM_TYPE(type)) {
@@ -107,21 +215,25 @@ bool vm_alloc_page_with_initializer(enum vm_type type, void *upage,
         break;
 
       default:
-        free(page);
+        kmem_cache_free(page_cachep, page);
         goto err;
     }
 
     uninit_new(page, upage, init, type, aux, initializer);
     page->writable = writable;
     page->type = type;
+    page->owner = thread_current(); /* added for copy-on-write */
 
     /* TODO: Insert the page into the spt. 
      * >  spt에 페이지를 삽입하십시오. */
     if (!spt_insert_page(spt, page)) {
-      free(page);
+      kmem_cache_free(page_cachep, page);
       goto err;
     }
 
+    /* added for VMA */
+    if (++page_cnt > page_peak) page_peak = page_cnt;
+
     succ = true;
   }
 
@@ -182,27 +294,548 @@ void spt_remove_page(struct supplemental_page_table *spt, struct page *page) {
   return;
 }
 
-/* Get the struct frame, that will be evicted. */
+/* ----------------- added for VMA ----------------- */
+
+/* spt->areas를 area의 시작 주소 순서로 정렬한다. */
+static bool area_less(const struct rb_node *a, const struct rb_node *b,
+                      void *aux UNUSED) {
+  return rb_entry(a, struct vm_area, area_elem)->start <
+         rb_entry(b, struct vm_area, area_elem)->start;
+}
+
+/**
+ * @brief spt로부터 va를 포함하는 area를 찾아 반환한다.
+ * 
+ * @return area ? area : NULL
+ * 
+ * @details area끼리는 겹치지 않으므로 start가 va 이하인 area 중 가장 뒤의 것만
+ *          확인하면 된다. O(log n)
+*/
+struct vm_area *spt_find_area(struct supplemental_page_table *spt, void *va) {
+  struct vm_area key = {.start = va}, *area;
+  struct rb_node *node;
+
+  node = rb_floor(&spt->areas, &key.area_elem);
+  if (node == NULL) return NULL;
+
+  area = rb_entry(node, struct vm_area, area_elem);
+  return va < area->end ? area : NULL;
+}
+
+/**
+ * @brief spt로부터 va에 해당하는 page를 찾고, 없으면 va를 포함하는 area에서
+ *        page를 만들어 반환한다.
+ * 
+ * @warning spt는 current thread의 spt여야 한다.
+ * 
+ * @return page ? page : NULL
+*/
+struct page *spt_get_page(struct supplemental_page_table *spt, void *va) {
+  struct page *page = spt_find_page(spt, va);
+  struct vm_area *area;
+
+  ASSERT(spt == &thread_current()->spt);
+
+  if (page != NULL) return page;
+
+  area = spt_find_area(spt, va);
+  return area != NULL ? area_new_page(area, pg_round_down(va)) : NULL;
+}
+
+/**
+ * @brief 현재 process에 [START, START + LENGTH) area를 등록한다.
+ * 
+ * @param file backing file. area는 duplicate한 file을 가진다. NULL이면 0으로 채운다.
+ * @param offset START에 대응하는 FILE의 offset
+ * @param read_bytes START부터 FILE에서 읽을 byte 수. 나머지는 0으로 채운다.
+ * @param init FILE에서 읽는 page에 넘길 init (file_segment_info를 aux로 받는다)
+ * 
+ * @return 등록한 area. 이미 등록된 area와 겹치거나 메모리가 부족하면 NULL
+ * 
+ * @details struct page는 만들지 않는다. page는 처음 page fault가 날 때
+ *          spt_get_page()가 만든다. 그래서 큰 BSS나 mapping도 등록 비용은
+ *          크기와 상관없이 일정하다.
+*/
+struct vm_area *vm_map_area(void *start, size_t length, bool writable,
+                            enum vm_type type, struct file *file, off_t offset,
+                            size_t read_bytes, vm_initializer *init) {
+  struct supplemental_page_table *spt = &thread_current()->spt;
+  struct vm_area *area;
+  struct rb_node *prev, *next;
+
+  ASSERT(pg_ofs(start) == 0 && length % PGSIZE == 0);
+  ASSERT(VM_TYPE(type) != VM_UNINIT);
+  ASSERT(read_bytes <= length);
+
+  if (start + length <= start) return NULL;
+
+  area = kmem_cache_zalloc(area_cachep);
+  if (area == NULL) return NULL;
+
+  area->start = start;
+  area->end = start + length;
+  area->writable = writable;
+  area->type = type;
+  area->offset = offset;
+  area->read_bytes = file != NULL ? read_bytes : 0;
+  area->init = init;
+
+  /* 앞의 area가 START 뒤에서 끝나거나 뒤의 area가 end 앞에서 시작하면 겹친다. */
+  prev = rb_floor(&spt->areas, &area->area_elem);
+  next = prev != NULL ? rb_next(prev) : rb_min(&spt->areas);
+  if ((prev != NULL &&
+       rb_entry(prev, struct vm_area, area_elem)->end > area->start) ||
+      (next != NULL &&
+       rb_entry(next, struct vm_area, area_elem)->start < area->end))
+    goto err;
+
+  if (file != NULL && (area->file = file_duplicate(file)) == NULL) goto err;
+
+  rb_insert(&spt->areas, &area->area_elem);
+  if (++area_cnt > area_peak) area_peak = area_cnt;
+  return area;
+
+err:
+  kmem_cache_free(area_cachep, area);
+  return NULL;
+}
+
+/* AREA가 가진 file을 닫고 AREA를 해제한다. AREA는 tree에서 빠져있어야 한다. */
+static void area_free(struct vm_area *area) {
+  file_close(area->file);
+  kmem_cache_free(area_cachep, area);
+  area_cnt--;
+}
+
+/**
+ * @brief current thread의 AREA와 그 안의 page를 모두 해제한다. (added for mmap)
+ * 
+ * @details 수정된 file page는 destroy(file_backed_destroy())가 file에 쓴다.
+ *          page를 만들지 않은 주소는 건너뛴다.
+*/
+void vm_unmap_area(struct vm_area *area) {
+  struct supplemental_page_table *spt = &thread_current()->spt;
+  void *va;
+
+  for (va = area->start; va < area->end; va += PGSIZE) {
+    struct page *page = spt_find_page(spt, va);
+
+    if (page == NULL) continue;
+    spt_remove_page(spt, page);
+    vm_dealloc_page(page);
+    page_cnt--;
+  }
+
+  rb_remove(&spt->areas, &area->area_elem);
+  area_free(area);
+}
+
+/**
+ * @brief current thread의 AREA 안에서 [START, END)의 file page를 해제한다.
+ *        (added for madvise)
+ * 
+ * @details vm_unmap_area()처럼 수정된 page는 file에 쓰고 struct page까지
+ *          없앤다. 다음에 접근하면 spt_get_page()가 area에서 uninit page를
+ *          다시 만들므로 fault-around로 다시 읽을 수 있다.
+ *          file에서 읽지 않는 anon page는 내용을 잃으므로 건너뛴다.
+*/
+static void area_release(struct vm_area *area, void *start, void *end) {
+  struct supplemental_page_table *spt = &thread_current()->spt;
+  void *va;
+
+  ASSERT(area->start <= start && end <= area->end);
+
+  for (va = start; va < end; va += PGSIZE) {
+    struct page *page = spt_find_page(spt, va);
+
+    if (page == NULL || VM_TYPE(page->operations->type) != VM_FILE) continue;
+    spt_remove_page(spt, page);
+    vm_dealloc_page(page);
+    page_cnt--;
+    release_cnt++;
+  }
+}
+
+/* current thread의 AREA 안에서 [START, END)의 file page를 지금 읽어온다.
+   읽다가 frame이 모자라면 멈춘다. (added for madvise) */
+static void area_prefetch(struct vm_area *area, void *start, void *end) {
+  struct supplemental_page_table *spt = &thread_current()->spt;
+  void *va;
+
+  ASSERT(area->start <= start && end <= area->end);
+
+  for (va = start; va < end; va += PGSIZE) {
+    struct page *page = spt_get_page(spt, va);
+    size_t want = DIV_ROUND_UP((size_t)(end - va), PGSIZE), cnt;
+
+    if (page == NULL) return;
+    if (page->frame == NULL && text_cache_map(page)) continue;
+    if (is_lazy_segment(page)) {
+      if (want > VM_FAULT_AROUND_MAX) want = VM_FAULT_AROUND_MAX;
+      cnt = vm_claim_segment(page, want, area->advice == VM_ADV_SEQUENTIAL);
+    } else if (page->frame == NULL &&
+               VM_TYPE(page->operations->type) == VM_FILE) {
+      cnt = vm_do_claim_page(page);
+    } else {
+      continue;
+    }
+
+    if (cnt == 0) return;
+    prefetch_cnt += cnt;
+  }
+}
+
+/**
+ * @brief current thread의 [ADDR, ADDR + LENGTH)에 madvise() hint를 준다.
+ *        (added for madvise)
+ * 
+ * @details NORMAL, RANDOM, SEQUENTIAL은 범위와 겹치는 area 전체에 기록하고
+ *          page fault를 처리할 때 쓴다. area를 나누지 않으므로 hint의 단위는
+ *          mmap() 하나이다.
+ *          WILLNEED와 DONTNEED는 기록하지 않고 범위의 page를 바로 읽어오거나
+ *          해제한다.
+ * 
+ * @return ADDR이 page 경계가 아니거나 범위가 mmap 밖을 포함하면 false
+*/
+bool vm_advise(void *addr, size_t length, enum vm_advice advice) {
+  struct supplemental_page_table *spt = &thread_current()->spt;
+  void *end = addr + length, *va;
+  struct vm_area *area;
+
+  if (pg_ofs(addr) != 0) return false;
+
+  for (va = addr; va < end; va = area->end) {
+    area = spt_find_area(spt, va);
+    if (area == NULL || !area->mmap) return false;
+  }
+
+  for (va = addr; va < end; va = area->end) {
+    void *stop;
+
+    area = spt_find_area(spt, va);
+    stop = end < area->end ? end : area->end;
+
+    switch (advice) {
+      case VM_ADV_NORMAL:
+      case VM_ADV_RANDOM:
+      case VM_ADV_SEQUENTIAL:
+        area->advice = advice;
+        break;
+      case VM_ADV_WILLNEED:
+        area_prefetch(area, va, stop);
+        break;
+      case VM_ADV_DONTNEED:
+        area_release(area, va, stop);
+        break;
+      default:
+        return false;
+    }
+  }
+
+  return true;
+}
+
+/* file에서 읽지 않는 area page와 stack page를 0으로 채운다.
+   이 init을 가진 uninit page는 읽기만 하는 동안 zero_frame을 매핑한다. */
+static bool zero_fill_page(struct page *page, void *aux UNUSED) {
+  memset(page->frame->kva, 0, PGSIZE);
+  return true;
+}
+
+/**
+ * @brief AREA 안의 VA에 해당하는 uninit page를 만들어 spt에 넣고 반환한다.
+ * 
+ * @details file에서 읽는 page는 load_segment()가 page마다 만들던 것과 같은
+ *          file_segment_info를 aux로 받으므로 lazy_load_segment()와
+ *          fault-around가 그대로 동작한다.
+*/
+static struct page *area_new_page(struct vm_area *area, void *va) {
+  struct supplemental_page_table *spt = &thread_current()->spt;
+  size_t ofs = va - area->start;
+  struct file_segment_info *aux = NULL;
+  vm_initializer *init = zero_fill_page;
+
+  if (ofs < area->read_bytes) {
+    aux = kmem_cache_zalloc(file_segment_cachep);
+    if (aux == NULL) return NULL;
+
+    aux->file = file_duplicate(area->file);
+    aux->offset = area->offset + ofs;
+    aux->read_bytes =
+        area->read_bytes - ofs < PGSIZE ? area->read_bytes - ofs : PGSIZE;
+    aux->zero_bytes = PGSIZE - aux->read_bytes;
+    init = area->init;
+  }
+
+  /* file에서 읽지 않는 page는 area의 type과 상관없이 anon page다. */
+  if ((aux != NULL && aux->file == NULL) ||
+      !vm_alloc_page_with_initializer(aux != NULL ? area->type : VM_ANON, va,
+                                      area->writable, init, aux)) {
+    if (aux != NULL) {
+      file_close(aux->file);
+      kmem_cache_free(file_segment_cachep, aux);
+    }
+    return NULL;
+  }
+
+  return spt_find_page(spt, va);
+}
+
+/**
+ * @brief clock hand를 한 칸 전진시키고, 가리키고 있던 frame을 반환한다.
+ * 
+ * @warning frame_lock을 들고 호출해야 하며 frame_table이 비어있으면 안된다.
+*/
+static struct frame *clock_advance(void) {
+  struct frame *frame;
+
+  if (clock_hand == NULL || clock_hand == list_end(&frame_table))
+    clock_hand = list_begin(&frame_table);
+
+  frame = list_entry(clock_hand, struct frame, frame_elem);
+  clock_hand = list_next(clock_hand);
+
+  return frame;
+}
+
+/**
+ * @brief FRAME을 매핑한 PTE 중 하나라도 accessed bit가 켜져있는지 확인하고,
+ *        모든 PTE의 accessed bit를 끈다.
+*/
+static bool frame_test_and_clear_accessed(struct frame *frame) {
+  bool accessed = false;
+  struct list_elem *e;
+
+  for (e = list_begin(&frame->mappings); e != list_end(&frame->mappings);
+       e = list_next(e)) {
+    struct page *page = list_entry(e, struct page, mapping_elem);
+    uint64_t *pml4 = page->owner->pml4;
+
+    if (pml4_is_accessed(pml4, page->va)) {
+      pml4_set_accessed(pml4, page->va, false);
+      accessed = true;
+    }
+  }
+
+  return accessed;
+}
+
+/**
+ * @brief PAGE가 FRAME을 쓰기 가능하게 매핑해도 되는지 반환한다.
+ * 
+ * @details 다른 page와 공유중인 frame은 copy-on-write를 위해 read-only로 매핑한다.
+*/
+static bool frame_writable(struct frame *frame, struct page *page) {
+  /* added for zero page : zero_frame은 혼자 매핑해도 쓰면 안된다. */
+  return frame != zero_frame && page->writable &&
+         list_size(&frame->mappings) == 1;
+}
+
+/* PAGE를 FRAME의 mappings에 추가한다. PTE는 호출자가 설정한다. */
+static void frame_map(struct frame *frame, struct page *page) {
+  list_push_back(&frame->mappings, &page->mapping_elem);
+  page->frame = frame;
+  if (frame->page == NULL) frame->page = page;
+}
+
+/* PAGE를 FRAME의 mappings에서 빼고 PAGE의 PTE를 지운다. */
+static void frame_unmap(struct frame *frame, struct page *page) {
+  list_remove(&page->mapping_elem);
+  pml4_clear_page(page->owner->pml4, page->va);
+  page->frame = NULL;
+
+  if (frame->page == page)
+    frame->page = list_empty(&frame->mappings)
+                      ? NULL
+                      : list_entry(list_front(&frame->mappings), struct page,
+                                   mapping_elem);
+}
+
+/**
+ * @brief clock(second-chance) 알고리즘으로 evict할 frame을 고른다.
+ * 
+ * @details clock hand가 frame_table을 원형으로 돌면서 frame을 매핑하고 있는
+ *          PTE의 accessed bit를 확인한다. bit가 켜져있으면 끄고 한 번 더
+ *          기회를 주고, 꺼져있으면 최근에 접근되지 않은 frame이므로 victim이 된다.
+ *          모든 frame의 bit가 켜져있어도 두 바퀴 안에 victim을 찾는다.
+ *          공유중인 frame은 매핑한 PTE 중 하나라도 접근되었으면 기회를 준다.
+ * 
+ *          pinned frame(swap in 중인 frame)과 아직 page와 연결되지 않은 frame은
+ *          건너뛴다. 두 바퀴를 돌아도 victim이 없으면 NULL을 반환한다.
+ *          madvise(MADV_SEQUENTIAL) area에서 읽은 streamed frame은 accessed bit와
+ *          상관없이 바로 victim이 된다.
+ * 
+ * @warning frame_lock을 들고 호출해야 한다.
+ * 
+ * @note Get the struct frame, that will be evicted.
+*/
 static struct frame *vm_get_victim(void) {
   struct frame *victim = NULL;
-  /* TODO: The policy for eviction is up to you. */
+  size_t tries = 2 * list_size(&frame_table);
+
+  ASSERT(lock_held_by_current_thread(&frame_lock));
+
+  while (tries-- > 0) {
+    struct frame *frame = clock_advance();
+
+    if (frame->pinned || frame->page == NULL) continue;
+    /* added for madvise : 한 번 읽고 지나가는 frame에는 기회를 더 주지 않는다. */
+    if (!frame->streamed && frame_test_and_clear_accessed(frame)) continue;
+
+    victim = frame;
+    break;
+  }
 
   return victim;
 }
 
-/* Evict one page and return the corresponding frame.
- * Return NULL on error.*/
+/**
+ * @brief FRAME을 frame_table에서 빼고 kva와 함께 해제한다.
+ * 
+ * @warning frame_lock을 들고 호출해야 한다.
+*/
+static void frame_remove(struct frame *frame) {
+  ASSERT(lock_held_by_current_thread(&frame_lock));
+  ASSERT(list_empty(&frame->mappings));
+
+  if (clock_hand == &frame->frame_elem) clock_hand = list_next(clock_hand);
+  list_remove(&frame->frame_elem);
+  frame_uncache(frame); /* added for shared text */
+  frame_cnt--;
+
+  palloc_free_page(frame->kva);
+  kmem_cache_free(frame_cachep, frame);
+}
+
+/* VICTIM을 매핑한 모든 PTE를 지우고, 모으는 동안 다시 고르지 않도록 pin한다. */
+static void victim_unmap(struct frame *victim) {
+  struct list_elem *e;
+
+  victim->pinned = true;
+  for (e = list_begin(&victim->mappings); e != list_end(&victim->mappings);
+       e = list_next(e)) {
+    struct page *page = list_entry(e, struct page, mapping_elem);
+
+    pml4_clear_page(page->owner->pml4, page->va);
+  }
+}
+
+/* evict하려고 지웠던 VICTIM의 매핑을 되돌린다. */
+static void victim_restore(struct frame *victim) {
+  struct list_elem *e;
+
+  for (e = list_begin(&victim->mappings); e != list_end(&victim->mappings);
+       e = list_next(e)) {
+    struct page *page = list_entry(e, struct page, mapping_elem);
+    bool dirty = pml4_is_dirty(page->owner->pml4, page->va);
+
+    pml4_set_page(page->owner->pml4, page->va, victim->kva,
+                  frame_writable(victim, page));
+    /* added for mmap : 새 PTE에 dirty bit을 되살려야 나중에 file에 쓴다. */
+    pml4_set_dirty(page->owner->pml4, page->va, dirty);
+  }
+  victim->pinned = false;
+}
+
+/* evict가 끝난 VICTIM과 그 page들의 연결을 끊는다. */
+static void victim_detach(struct frame *victim) {
+  while (!list_empty(&victim->mappings)) {
+    struct page *page =
+        list_entry(list_front(&victim->mappings), struct page, mapping_elem);
+
+    frame_unmap(victim, page);
+  }
+  victim->pinned = false;
+}
+
+/**
+ * @brief victim frame의 page를 swap out하고 비워진 frame을 반환한다.
+ * 
+ * @details victim을 매핑한 모든 pml4에서 매핑을 먼저 지워서 swap out 도중
+ *          접근하면 page fault가 나도록 한다. 그 fault는 vm_get_frame()에서
+ *          frame_lock을 기다리므로 swap out이 끝난 뒤에 page를 다시 읽어온다.
+ *          swap out에 실패하면 매핑을 되돌리고 NULL을 반환한다.
+ * 
+ *          victim이 anon page이면 clock을 계속 돌려 anon victim을 SWAP_CLUSTER개
+ *          까지 모으고, 연속된 swap slot에 한 번의 disk command로 쓴다.
+ *          첫 victim의 frame만 반환하고 나머지는 user pool에 돌려주므로,
+ *          이어지는 page fault는 eviction 없이 frame을 얻는다.
+ * 
+ *          반환된 frame은 frame_table에 남아있고 호출자가 재사용한다.
+ * 
+ * @warning frame_lock을 들고 호출해야 한다. file page를 file에 쓰는 동안에는
+ *          lock을 잠시 놓는다.
+ * 
+ * @note Evict one page and return the corresponding frame.
+ *       Return NULL on error.
+*/
 static struct frame *vm_evict_frame(void) {
-  struct frame *victim UNUSED = vm_get_victim();
-  /* TODO: swap out the victim and return the evicted frame. */
+  struct frame *victims[SWAP_CLUSTER];
+  struct frame *victim = vm_get_victim();
+  size_t cnt = 0, i;
+
+  if (victim == NULL) return NULL;
+
+  if (VM_TYPE(victim->page->operations->type) != VM_ANON) {
+    struct list_elem *e;
+    bool succ = true;
+
+    victim_unmap(victim);
+
+    /* added for mmap : file_write_at()은 inode lock을 잡고 disk를 기다리므로
+       frame_lock을 놓고 쓴다. victim은 pinned라 다시 골라지지 않고,
+       writeback이 끝날 때까지 아무도 mappings를 바꾸지 않는다. */
+    victim->writeback = true;
+    lock_release(&frame_lock);
+    for (e = list_begin(&victim->mappings); e != list_end(&victim->mappings);
+         e = list_next(e))
+      if (!swap_out(list_entry(e, struct page, mapping_elem))) {
+        succ = false;
+        break;
+      }
+    lock_acquire(&frame_lock);
+    writeback_done(victim);
 
-  return NULL;
+    if (!succ) {
+      victim_restore(victim);
+      return NULL;
+    }
+    evict_cnt++;
+    victim_detach(victim);
+    frame_uncache(victim); /* added for shared text */
+    return victim;
+  }
+
+  do {
+    victim_unmap(victim);
+    victims[cnt++] = victim;
+  } while (cnt < SWAP_CLUSTER && (victim = vm_get_victim()) != NULL &&
+           VM_TYPE(victim->page->operations->type) == VM_ANON);
+
+  /* 연속된 slot이 모자라면 cluster를 줄여가며 다시 시도한다. */
+  while (!anon_swap_out_cluster(victims, cnt)) {
+    victim_restore(victims[--cnt]);
+    if (cnt == 0) return NULL;
+  }
+
+  evict_cnt += cnt;
+  for (i = 0; i < cnt; i++) {
+    victim_detach(victims[i]);
+    if (i > 0) frame_remove(victims[i]);
+  }
+
+  return victims[0];
 }
 
 /**
  * @brief physical memory에서 page만큼의 공간을 할당하고 할당한 블럭의 ptr을 
  *        들고있는 frame을 반환한다.
  * 
+ * @details user pool이 가득 차면 frame 하나를 evict해서 재사용한다.
+ *          반환된 frame은 frame_table에 들어있고 pinned 상태이므로, 호출자는
+ *          page를 연결하고 내용을 채운 뒤 pinned를 풀어야 한다.
+ *          evict할 frame도 없으면 NULL을 반환한다.
+ * 
  * @note palloc() and get frame. If there is no available page, evict the page
  *       and return it. This always return valid address. That is, if the user pool
  *       memory is full, this function evicts the frame to get the available memory
@@ -211,26 +844,360 @@ static struct frame *vm_evict_frame(void) {
  *       >  palloc() 및 프레임을 가져옵니다. 사용 가능한 페이지가 없으면 페이지를 제거하고 반환합니다.
  *       >  이 함수는 항상 유효한 주소를 반환합니다. 즉, 사용자 풀 메모리가 가득 차면 이 함수는
  *       >  사용 가능한 메모리를 얻기 위해 프레임을 제거합니다.
- * 
- * TODO: Fill this function.
 */
 static struct frame *vm_get_frame(void) {
-  struct page *new_page = NULL;
+  return frame_alloc(true);
+}
+
+/**
+ * @brief vm_get_frame()의 본체. EVICT가 false이면 user pool이 가득 찼을 때
+ *        evict하지 않고 NULL을 반환한다. (added for fault-around)
+*/
+static struct frame *frame_alloc(bool evict) {
   struct frame *frame = NULL;
+  void *kva;
+
+  kva = palloc_get_page(PAL_USER); /* GITBOOK : user pool */
+  if (kva == NULL && !evict) return NULL;
+
+  lock_acquire(&frame_lock);
+
+  if (kva != NULL) {
+    frame = kmem_cache_zalloc(frame_cachep);
+    if (frame == NULL) {
+      palloc_free_page(kva);
+    } else {
+      frame->kva = kva;
+      list_init(&frame->mappings);
+      list_push_back(&frame_table, &frame->frame_elem);
+      if (++frame_cnt > frame_peak) frame_peak = frame_cnt;
+    }
+  } else {
+    /* ----------- before frame table -----------
+    if (!new_page) PANIC("TODO !"); */
+    frame = vm_evict_frame();
+  }
 
-  new_page = palloc_get_page(PAL_USER); /* GITBOOK : user pool */
-  if (!new_page) PANIC("TODO !");
+  if (frame != NULL) {
+    frame->pinned = true;
+    frame->streamed = false; /* added for madvise */
+  }
 
-  frame = (struct frame *)calloc(1, sizeof(struct frame));
-  frame->kva = new_page;
-  frame->page = NULL;
+  lock_release(&frame_lock);
 
-  ASSERT(frame != NULL);
-  ASSERT(frame->page == NULL);
+  ASSERT(frame == NULL || frame->page == NULL);
 
   return frame;
 }
 
+/**
+ * @brief page를 frame에서 떼어내고, 마지막 page였으면 frame을 해제한다.
+ * 
+ * @details page의 매핑도 지운다. pml4_destroy()는 present인 PTE의 frame을
+ *          palloc_free_page()하므로, 여기서 매핑을 지우지 않으면 같은 frame을
+ *          두 번 해제하게 된다.
+ *          frame_lock 안에서 page->frame을 읽어야 eviction과 경쟁하지 않는다.
+*/
+void vm_free_frame(struct page *page) {
+  struct frame *frame;
+
+  lock_acquire(&frame_lock);
+
+  frame = page_frame(page);
+  if (frame != NULL) {
+    frame_unmap(frame, page);
+    if (list_empty(&frame->mappings) && frame != zero_frame)
+      frame_remove(frame);
+  }
+
+  lock_release(&frame_lock);
+}
+
+/**
+ * @brief file page PAGE가 frame에 있으면 swap_out()으로 수정된 내용을 file에
+ *        쓴다. frame은 그대로 둔다. (added for mmap)
+ * 
+ * @details eviction처럼 frame을 pin하고 writeback으로 표시한 뒤 frame_lock을
+ *          놓고 쓴다. 쓰는 동안 frame은 evict되지 않는다.
+*/
+bool vm_sync_page(struct page *page) {
+  struct frame *frame;
+  bool succ = true;
+
+  ASSERT(VM_TYPE(page->operations->type) == VM_FILE);
+
+  lock_acquire(&frame_lock);
+  frame = page_frame(page);
+  if (frame != NULL) {
+    bool pinned = frame->pinned;
+
+    frame->pinned = frame->writeback = true;
+    lock_release(&frame_lock);
+    succ = swap_out(page);
+    lock_acquire(&frame_lock);
+    frame->pinned = pinned;
+    writeback_done(frame);
+  }
+  lock_release(&frame_lock);
+
+  return succ;
+}
+
+/**
+ * @brief PAGE가 매핑한 frame을 반환한다. frame이 writeback 중이면 끝날 때까지
+ *        기다린다. (added for mmap)
+ * 
+ * @details 기다리는 동안 frame이 evict되었으면 NULL을 반환한다.
+ * 
+ * @warning frame_lock을 들고 호출해야 한다.
+*/
+static struct frame *page_frame(struct page *page) {
+  ASSERT(lock_held_by_current_thread(&frame_lock));
+
+  while (page->frame != NULL && page->frame->writeback)
+    cond_wait(&writeback_cond, &frame_lock);
+
+  return page->frame;
+}
+
+/* FRAME의 writeback이 끝났음을 표시하고 page_frame()에서 기다리는 thread를
+   깨운다. frame_lock을 들고 호출해야 한다. */
+static void writeback_done(struct frame *frame) {
+  frame->writeback = false;
+  cond_broadcast(&writeback_cond, &frame_lock);
+}
+
+/**
+ * @brief 부모 page PARENT의 frame을 자식 page CHILD와 공유한다.
+ * 
+ * @details 두 PTE 모두 read-only로 매핑하고, 먼저 쓰는 쪽이 vm_handle_wp()에서
+ *          자신만의 frame을 받는다. PARENT가 swap out되어 있으면 swap slot을
+ *          공유한다. PARENT가 evict된 file page이면 CHILD는 file에서 다시 읽는다.
+ *          fork() 중인 부모는 sema에서 기다리고 있으므로 부모의 PTE를 바꿔도 된다.
+ *          부모의 dirty bit은 남겨두어야 mmap page가 나중에 file에 쓰인다.
+*/
+static void vm_share_page(struct page *child, struct page *parent) {
+  struct frame *frame;
+
+  lock_acquire(&frame_lock);
+
+  frame = page_frame(parent);
+  if (frame != NULL) {
+    uint64_t *pml4 = parent->owner->pml4;
+    bool dirty = pml4_is_dirty(pml4, parent->va); /* added for mmap */
+
+    frame_map(frame, child);
+    pml4_set_page(pml4, parent->va, frame->kva, false);
+    pml4_set_dirty(pml4, parent->va, dirty);
+    pml4_set_page(child->owner->pml4, child->va, frame->kva, false);
+  } else if (VM_TYPE(parent->operations->type) == VM_ANON) {
+    anon_swap_dup(child, parent);
+  }
+
+  lock_release(&frame_lock);
+}
+
+/* ----------------- added for zero page ----------------- */
+
+/**
+ * @brief PAGE가 아직 한 번도 load되지 않은 zero-fill page이면 zero_frame을
+ *        읽기 전용으로 매핑한다.
+ * 
+ * @details PAGE는 uninit page로 남는다. 처음 쓸 때 write-protect fault가 나고
+ *          vm_handle_wp()가 새 frame에 복사한 뒤 anon page로 초기화한다.
+ * 
+ * @return 매핑했으면 true
+*/
+static bool vm_map_zero(struct page *page) {
+  bool succ;
+
+  if (VM_TYPE(page->operations->type) != VM_UNINIT ||
+      VM_TYPE(page->uninit.type) != VM_ANON ||
+      page->uninit.init != zero_fill_page)
+    return false;
+
+  lock_acquire(&frame_lock);
+  frame_map(zero_frame, page);
+  succ = pml4_set_page(page->owner->pml4, page->va, zero_frame->kva, false);
+  if (succ)
+    zero_map_cnt++;
+  else
+    frame_unmap(zero_frame, page);
+  lock_release(&frame_lock);
+
+  return succ;
+}
+
+/* ----------------- added for shared text ----------------- */
+
+/**
+ * @brief PAGE가 text_cache로 공유할 수 있는 page이면 내용을 읽어올 file의
+ *        inode와 offset을 알려준다.
+ * 
+ * @details 공유하는 page는 읽기 전용 file page(아직 load하지 않은 uninit page
+ *          포함)이다. file의 끝에 걸쳐 일부만 읽는 page는 mapping마다 0으로
+ *          채우는 범위가 다를 수 있으므로 공유하지 않는다.
+*/
+static bool text_key(struct page *page, struct inode **inode, off_t *offset) {
+  struct file *file;
+  uint32_t read_bytes;
+
+  if (page->writable) return false;
+
+  if (VM_TYPE(page->operations->type) == VM_UNINIT) {
+    struct file_segment_info *aux = page->uninit.aux;
+
+    if (VM_TYPE(page->uninit.type) != VM_FILE || aux == NULL) return false;
+    file = aux->file;
+    *offset = aux->offset;
+    read_bytes = aux->read_bytes;
+  } else if (VM_TYPE(page->operations->type) == VM_FILE) {
+    file = page->file.file;
+    *offset = page->file.offset;
+    read_bytes = page->file.read_bytes;
+  } else {
+    return false;
+  }
+
+  /* added for mmap : 쓸 수 있는 file은 내용이 바뀔 수 있으므로 공유하지 않는다. */
+  if (file == NULL || read_bytes != PGSIZE || !file_write_denied(file))
+    return false;
+
+  *inode = file_get_inode(file);
+  return true;
+}
+
+/**
+ * @brief text_cache에서 INODE의 OFFSET을 담고 있는 frame을 찾는다.
+ * 
+ * @warning frame_lock을 들고 호출해야 한다.
+*/
+static struct frame *text_cache_find(struct inode *inode, off_t offset) {
+  struct frame key;
+  struct hash_elem *e;
+
+  key.inode = inode;
+  key.offset = offset;
+  e = hash_find(&text_cache, &key.cache_elem);
+
+  return e != NULL ? hash_entry(e, struct frame, cache_elem) : NULL;
+}
+
+/**
+ * @brief PAGE의 내용이 이미 text_cache에 있으면 그 frame을 PAGE에 읽기 전용으로
+ *        매핑한다.
+ * 
+ * @details 아직 uninit page이면 file page로 초기화만 하고 file은 읽지 않는다.
+ *          초기화는 file_duplicate()가 inode lock을 잡을 수 있으므로 frame_lock
+ *          밖에서 하고, frame은 다시 찾는다.
+ *          evict 중이거나 읽는 중인(pinned) frame은 공유하지 않는다.
+ * 
+ * @return 매핑했으면 true. false이면 호출자가 평소처럼 page를 읽어온다.
+*/
+static bool text_cache_map(struct page *page) {
+  struct inode *inode;
+  off_t offset;
+  struct frame *frame;
+  bool succ = false;
+
+  if (!text_cached(page)) return false;
+
+  if (VM_TYPE(page->operations->type) == VM_UNINIT) {
+    struct file_segment_info *aux = page->uninit.aux;
+
+    /* vm_claim_segment()처럼 lazy_load_segment()가 할 일을 대신 한다. */
+    if (!page->uninit.page_initializer(page, page->uninit.type, NULL))
+      return false;
+    file_close(aux->file);
+    kmem_cache_free(file_segment_cachep, aux);
+  }
+
+  if (!text_key(page, &inode, &offset)) return false;
+
+  lock_acquire(&frame_lock);
+
+  frame = text_cache_find(inode, offset);
+  if (frame == NULL || frame->pinned) goto done;
+
+  frame_map(frame, page);
+  if (!pml4_set_page(page->owner->pml4, page->va, frame->kva, false)) {
+    frame_unmap(frame, page);
+    goto done;
+  }
+
+  text_hit_cnt++;
+  succ = true;
+
+done:
+  lock_release(&frame_lock);
+  return succ;
+}
+
+/* PAGE의 내용이 이미 text_cache에 있으면 true */
+static bool text_cached(struct page *page) {
+  struct inode *inode;
+  off_t offset;
+  bool cached;
+
+  if (!text_key(page, &inode, &offset)) return false;
+
+  lock_acquire(&frame_lock);
+  cached = text_cache_find(inode, offset) != NULL;
+  lock_release(&frame_lock);
+
+  return cached;
+}
+
+/**
+ * @brief PAGE의 내용을 읽어온 FRAME을 text_cache에 넣는다.
+ * 
+ * @details 공유할 수 없는 page이거나 같은 내용의 frame이 이미 있으면(두 process가
+ *          동시에 읽은 경우) 넣지 않는다. 그 frame은 PAGE 혼자 쓴다.
+ * 
+ * @warning frame_lock을 들고 호출해야 한다.
+*/
+static void frame_cache(struct frame *frame, struct page *page) {
+  struct inode *inode;
+  off_t offset;
+
+  ASSERT(frame->inode == NULL);
+
+  if (!text_key(page, &inode, &offset)) return;
+
+  frame->inode = inode;
+  frame->offset = offset;
+  if (hash_insert(&text_cache, &frame->cache_elem) != NULL)
+    frame->inode = NULL;
+}
+
+/**
+ * @brief FRAME을 text_cache에서 뺀다. frame을 해제하거나 evict할 때 부른다.
+ * 
+ * @warning frame_lock을 들고 호출해야 한다.
+*/
+static void frame_uncache(struct frame *frame) {
+  if (frame->inode == NULL) return;
+
+  hash_delete(&text_cache, &frame->cache_elem);
+  frame->inode = NULL;
+}
+
+static uint64_t text_cache_hash(const struct hash_elem *e, void *aux UNUSED) {
+  struct frame *frame = hash_entry(e, struct frame, cache_elem);
+
+  return hash_bytes(&frame->inode, sizeof frame->inode) ^
+         hash_int(frame->offset);
+}
+
+static bool text_cache_less(const struct hash_elem *a,
+                            const struct hash_elem *b, void *aux UNUSED) {
+  struct frame *f_a = hash_entry(a, struct frame, cache_elem);
+  struct frame *f_b = hash_entry(b, struct frame, cache_elem);
+
+  if (f_a->inode != f_b->inode) return f_a->inode < f_b->inode;
+  return f_a->offset < f_b->offset;
+}
+
 /* Growing the stack. */
 /**
  * @brief page fault가 발생한 주소를 기준으로 stack을 확장한다.
@@ -246,7 +1213,10 @@ static void vm_stack_growth(void *addr UNUSED) {
   void *page_addr = pg_round_down(addr);
 
   while (spt_find_page(spt, page_addr) == NULL) {
-    succ = vm_alloc_page(VM_ANON, page_addr, true);
+    /* ------- before zero page -------
+    succ = vm_alloc_page(VM_ANON, page_addr, true); */
+    succ = vm_alloc_page_with_initializer(VM_ANON, page_addr, true,
+                                          zero_fill_page, NULL);
     if (!succ) PANIC("BAAAAAM !!");
 
     page_addr += PGSIZE;
@@ -256,7 +1226,61 @@ static void vm_stack_growth(void *addr UNUSED) {
 }
 
 /* Handle the fault on write_protected page */
-static bool vm_handle_wp(struct page *page UNUSED) {}
+/**
+ * @brief copy-on-write로 공유중인 page에 쓰려고 할 때 공유를 끊는다.
+ * 
+ * @details 다른 page와 공유하지 않는 frame이면 PTE를 쓰기 가능하게 바꾸기만 하고,
+ *          공유중이면 새 frame에 내용을 복사해서 page를 옮긴다. 원래 frame은
+ *          나머지 page가 계속 쓴다.
+ *          frame을 얻는 동안 page가 evict되었으면 아무것도 하지 않고 true를
+ *          반환한다. 다시 접근하면 not-present fault로 page를 읽어온다.
+ * 
+ * @note Handle the fault on write_protected page
+*/
+static bool vm_handle_wp(struct page *page) {
+  struct frame *old_frame, *new_frame;
+  uint64_t *pml4 = page->owner->pml4;
+
+  lock_acquire(&frame_lock);
+  old_frame = page_frame(page);
+  if (old_frame == NULL || frame_writable(old_frame, page)) {
+    if (old_frame != NULL)
+      pml4_set_page(pml4, page->va, old_frame->kva, true);
+    lock_release(&frame_lock);
+    return true;
+  }
+  lock_release(&frame_lock);
+
+  new_frame = vm_get_frame();
+  if (new_frame == NULL) return false;
+
+  lock_acquire(&frame_lock);
+  if (page_frame(page) != old_frame) {
+    /* frame을 얻는 동안 evict되었다. */
+    frame_remove(new_frame);
+  } else {
+    memcpy(new_frame->kva, old_frame->kva, PGSIZE);
+    frame_unmap(old_frame, page);
+    if (list_empty(&old_frame->mappings) && old_frame != zero_frame)
+      frame_remove(old_frame);
+
+    frame_map(new_frame, page);
+    pml4_set_page(pml4, page->va, new_frame->kva, true);
+    new_frame->pinned = false;
+
+    /* added for zero page : 이제서야 page를 anon page로 초기화한다.
+       내용은 zero_frame에서 복사했으므로 init은 부르지 않는다. */
+    if (old_frame == zero_frame) {
+      page->uninit.page_initializer(page, page->uninit.type, new_frame->kva);
+      zero_break_cnt++;
+    } else {
+      cow_cnt++;
+    }
+  }
+  lock_release(&frame_lock);
+
+  return true;
+}
 
 /**
  * @brief page fault시에 handling을 시도한다.
@@ -282,7 +1306,11 @@ bool vm_try_handle_fault(struct intr_frame *f UNUSED, void *addr UNUSED,
 
   if (user && is_kernel_vaddr(addr)) return false;
 
-  page = spt_find_page(spt, page_addr);
+  fault_cnt++; /* added for fault-around */
+
+  /* ------- before VMA -------
+  page = spt_find_page(spt, page_addr); */
+  page = spt_get_page(spt, page_addr);
 
   if (!page) {
     if (!not_present) return false; /*  */
@@ -302,10 +1330,180 @@ bool vm_try_handle_fault(struct intr_frame *f UNUSED, void *addr UNUSED,
     /* page는 R/O인데 write 작업을 하려는 경우 */
     if (page->writable == false && write == true) return false;
 
+    /* added for copy-on-write : 공유중이라 read-only로 매핑된 page에 쓰는 경우 */
+    if (!not_present) return write && vm_handle_wp(page);
+
+    /* added for zero page : 아직 쓰지 않은 zero-fill page를 읽는 경우 */
+    if (!write && vm_map_zero(page)) return true;
+
+    /* added for shared text : 다른 process가 이미 읽어온 text page */
+    if (text_cache_map(page)) return true;
+
+    /* added for fault-around */
+    /* ------- before madvise -------
+    if (is_lazy_segment(page)) return vm_claim_segment(page); */
+    if (is_lazy_segment(page)) return vm_claim_advised(page);
+
     return vm_claim_page(page_addr);
   }
 }
 
+/**
+ * @brief lazy load되는 PAGE를 PAGE가 속한 area의 madvise() hint에 따라
+ *        load한다. (added for madvise)
+ * 
+ * @details RANDOM이면 PAGE 하나만, SEQUENTIAL이면 VM_FAULT_AROUND_MAX개까지,
+ *          그 외에는 vm_fault_around개까지 읽는다.
+ *          SEQUENTIAL이면 읽은 frame을 streamed로 표시하고, 읽은 곳보다 한
+ *          window 이상 뒤에 있는 한 window의 page를 해제한다(drop-behind).
+ *          순서대로 읽으면 fault는 window마다 한 번 나므로 지나간 page는 모두
+ *          해제되고, 놓친 page는 eviction이 먼저 가져간다.
+*/
+static bool vm_claim_advised(struct page *page) {
+  struct vm_area *area = spt_find_area(&page->owner->spt, page->va);
+  enum vm_advice advice = area != NULL ? area->advice : VM_ADV_NORMAL;
+  size_t window = VM_FAULT_AROUND_MAX * PGSIZE, ofs;
+
+  if (advice == VM_ADV_RANDOM) return vm_claim_segment(page, 1, false) > 0;
+  if (advice != VM_ADV_SEQUENTIAL)
+    return vm_claim_segment(page, vm_fault_around, false) > 0;
+
+  if (vm_claim_segment(page, VM_FAULT_AROUND_MAX, true) == 0) return false;
+
+  ofs = page->va - area->start;
+  if (ofs > window)
+    area_release(area, ofs > 2 * window ? page->va - 2 * window : area->start,
+                 page->va - window);
+  return true;
+}
+
+/* PAGE가 아직 load되지 않은 file segment(load_segment()가 만든 page)이면 true */
+static bool is_lazy_segment(struct page *page) {
+  return VM_TYPE(page->operations->type) == VM_UNINIT &&
+         page->uninit.aux != NULL;
+}
+
+/* NEXT가 file에서 PREV 바로 다음 page를 읽는 segment page이면 true */
+static bool segment_continues(struct page *prev, struct page *next) {
+  struct file_segment_info *a = prev->uninit.aux;
+  struct file_segment_info *b;
+
+  if (next == NULL || !is_lazy_segment(next) ||
+      next->uninit.init != prev->uninit.init)
+    return false;
+
+  b = next->uninit.aux;
+  return file_get_inode(a->file) == file_get_inode(b->file) &&
+         a->read_bytes == PGSIZE && b->offset == a->offset + PGSIZE &&
+         b->read_bytes > 0;
+}
+
+/**
+ * @brief lazy load되는 segment의 PAGE와 그 뒤의 page들을 한꺼번에 load한다.
+ * 
+ * @details PAGE부터 file에서 이어지는 segment page를 최대 vm_fault_around개
+ *          모아서 한 번의 file_read_at()으로 읽는다. inode_read_at()은 disk에서
+ *          이어지는 sector를 한 command로 읽으므로 page마다 읽는 것보다 훨씬 싸다.
+ *          PAGE가 아닌 page의 frame은 evict하지 않고 얻을 수 있을 때만 받는다.
+ * 
+ *          모을 page가 없거나 bounce buffer를 얻지 못하면 vm_claim_page()처럼
+ *          PAGE 하나만 load한다.
+ * 
+ *          added for madvise : 최대 WANT개를 읽고, STREAMED이면 frame을
+ *          streamed로 표시한다. load한 page 수를 반환한다. (실패하면 0)
+ * 
+ * @see lazy_load_segment()
+*/
+static size_t vm_claim_segment(struct page *page, size_t want, bool streamed) {
+  struct supplemental_page_table *spt = &page->owner->spt;
+  struct page *run[VM_FAULT_AROUND_MAX];
+  struct frame *frames[VM_FAULT_AROUND_MAX];
+  struct file_segment_info *first;
+  size_t cnt = 0, i;
+  off_t read_bytes = 0;
+  uint8_t *bounce = NULL;
+
+  if (want > VM_FAULT_AROUND_MAX) want = VM_FAULT_AROUND_MAX;
+
+  run[0] = page;
+  for (cnt = 1; cnt < want; cnt++) {
+    run[cnt] = spt_get_page(spt, run[cnt - 1]->va + PGSIZE);
+    if (!segment_continues(run[cnt - 1], run[cnt])) break;
+    /* added for shared text : 이미 읽어온 page는 다시 읽지 않는다. */
+    if (text_cached(run[cnt])) break;
+  }
+  if (cnt == 1) {
+    if (!vm_do_claim_page(page)) return 0;
+    lock_acquire(&frame_lock);
+    if (page->frame != NULL) page->frame->streamed = streamed;
+    lock_release(&frame_lock);
+    return 1;
+  }
+
+  frames[0] = vm_get_frame();
+  if (frames[0] == NULL) return 0;
+  for (i = 1; i < cnt; i++) {
+    frames[i] = frame_alloc(false);
+    if (frames[i] == NULL) break;
+  }
+  cnt = i;
+
+  first = page->uninit.aux;
+  for (i = 0; i < cnt; i++)
+    read_bytes += ((struct file_segment_info *)run[i]->uninit.aux)->read_bytes;
+
+  if (cnt > 1) bounce = palloc_get_multiple(0, cnt);
+  if (bounce == NULL ||
+      file_read_at(first->file, bounce, read_bytes, first->offset) !=
+          read_bytes) {
+    /* 하나씩 load하는 원래 방법으로 되돌아간다. */
+    if (bounce != NULL) palloc_free_multiple(bounce, cnt);
+    lock_acquire(&frame_lock);
+    for (i = 0; i < cnt; i++) frame_remove(frames[i]);
+    lock_release(&frame_lock);
+    return vm_do_claim_page(page);
+  }
+
+  for (i = 0; i < cnt; i++) {
+    struct page *p = run[i];
+    struct file_segment_info *aux = p->uninit.aux;
+    void *kva = frames[i]->kva;
+
+    lock_acquire(&frame_lock);
+    frame_map(frames[i], p);
+    lock_release(&frame_lock);
+    if (!pml4_set_page(p->owner->pml4, p->va, kva, p->writable)) break;
+
+    memcpy(kva, bounce + i * PGSIZE, aux->read_bytes);
+    memset(kva + aux->read_bytes, 0, aux->zero_bytes);
+
+    /* lazy_load_segment()가 할 일을 대신 했으므로 initializer만 부른다. */
+    p->uninit.page_initializer(p, p->uninit.type, kva);
+    file_close(aux->file);
+    kmem_cache_free(file_segment_cachep, aux);
+
+    lock_acquire(&frame_lock);
+    frame_cache(frames[i], p); /* added for shared text */
+    frames[i]->streamed = streamed; /* added for madvise */
+    frames[i]->pinned = false;
+    lock_release(&frame_lock);
+  }
+  palloc_free_multiple(bounce, cnt);
+
+  /* 매핑하지 못한 page는 uninit page로 남겨두고 frame만 돌려준다. */
+  if (i < cnt) {
+    size_t j;
+
+    lock_acquire(&frame_lock);
+    frame_unmap(frames[i], run[i]);
+    for (j = i; j < cnt; j++) frame_remove(frames[j]);
+    lock_release(&frame_lock);
+  }
+
+  if (i > 0) fault_around_cnt += i - 1;
+  return i;
+}
+
 /**
  * @brief page를 해제한다.
  * 
@@ -313,7 +1511,8 @@ bool vm_try_handle_fault(struct intr_frame *f UNUSED, void *addr UNUSED,
 */
 void vm_dealloc_page(struct page *page) {
   destroy(page);
-  free(page);
+  /* added for slab allocator : free(page) */
+  kmem_cache_free(page_cachep, page);
 }
 
 /**
@@ -363,20 +1562,43 @@ static bool vm_do_claim_page(struct page *page) {
   struct thread *curr_t = thread_current();
   struct frame *frame = vm_get_frame();
   bool writable = page->writable;
+  bool succ;
+
+  if (frame == NULL) return false; /* added for frame table */
+
+  lock_acquire(&frame_lock);
+  if (page_frame(page) != NULL) {
+    /* frame을 얻는 동안 evict가 실패해서 매핑이 되돌아왔다. */
+    frame_remove(frame);
+    lock_release(&frame_lock);
+    return true;
+  }
 
   /* page 구조체와 frame 구조체의 연결 */
+  /* ------- before copy-on-write -------
   frame->page = page;
-  page->frame = frame;
+  page->frame = frame; */
+  frame_map(frame, page);
+  lock_release(&frame_lock);
 
   /* TODO: Insert page table entry to map page's VA to frame's PA. */
   /*  */
   if (!pml4_set_page(curr_t->pml4, page->va, frame->kva, writable)) {
+    vm_free_frame(page);
     return false;
   }
 
   /* ---------------------------------------------------------- */
 
-  return swap_in(page, frame->kva);
+  /* swap in이 끝날 때까지 pinned 상태로 두어 evict되지 않게 한다. */
+  succ = swap_in(page, frame->kva);
+
+  lock_acquire(&frame_lock);
+  if (succ) frame_cache(frame, page); /* added for shared text */
+  frame->pinned = false;
+  lock_release(&frame_lock);
+
+  return succ;
 }
 
 /**
@@ -388,6 +1610,7 @@ static bool vm_do_claim_page(struct page *page) {
 */
 void supplemental_page_table_init(struct supplemental_page_table *spt UNUSED) {
   hash_init(&spt->page_table, hash_page_hash, cmp_page_hash, NULL);
+  rb_init(&spt->areas, area_less, NULL); /* added for VMA */
 }
 
 /**
@@ -411,20 +1634,43 @@ bool supplemental_page_table_copy(struct supplemental_page_table *dst UNUSED,
   struct page *parent_page, *child_page = NULL;
   struct file_segment_info *src_aux, *dst_aux = NULL;
   enum vm_type curr_page_type;
+  struct rb_node *node;
   bool succ = false;
 
+  /* added for VMA : area를 먼저 복사한다. 아직 page가 없는 주소는 child가
+     처음 접근할 때 자신의 area에서 page를 만든다.
+     mmap()한 area도 같은 file을 가리키는 area로 물려준다. (added for mmap) */
+  for (node = rb_min(&src->areas); node != NULL; node = rb_next(node)) {
+    struct vm_area *area = rb_entry(node, struct vm_area, area_elem);
+    struct vm_area *copy;
+
+    copy = vm_map_area(area->start, area->end - area->start, area->writable,
+                       area->type, area->file, area->offset, area->read_bytes,
+                       area->init);
+    if (copy == NULL) goto err;
+    copy->mmap = area->mmap;     /* added for mmap */
+    copy->advice = area->advice; /* added for madvise */
+  }
+
   hash_first(&iterator, &src->page_table);
 
   while (hash_next(&iterator)) {
+    struct vm_area *area;
+
     parent_page = hash_entry(hash_cur(&iterator), struct page, spt_elem);
     curr_page_type = VM_TYPE(parent_page->operations->type);
 
+    area = spt_find_area(src, parent_page->va);
+
     switch (curr_page_type) {
 
       case VM_UNINIT:
         src_aux = (struct file_segment_info *)parent_page->uninit.aux;
-        dst_aux = (struct file_segment_info *)calloc(
-            1, sizeof(struct file_segment_info));
+        dst_aux = NULL;
+        /* added for VMA : 0으로 채우는 page는 aux가 없다. */
+        if (src_aux == NULL) goto alloc_uninit;
+
+        dst_aux = kmem_cache_zalloc(file_segment_cachep);
         if (!dst_aux) goto err;
 
         memcpy(dst_aux, src_aux, sizeof(struct file_segment_info));
@@ -434,11 +1680,15 @@ bool supplemental_page_table_copy(struct supplemental_page_table *dst UNUSED,
            dst_aux->offset = src_aux->offset; 
            dst_aux->zero_bytes = src_aux->zero_bytes; */
 
+      alloc_uninit:
         if (!vm_alloc_page_with_initializer(
                 page_get_type(parent_page), parent_page->va,
                 parent_page->writable, parent_page->uninit.init, dst_aux)) {
 
-          free(dst_aux);
+          if (dst_aux != NULL) {
+            file_close(dst_aux->file);
+            kmem_cache_free(file_segment_cachep, dst_aux);
+          }
           goto err;
         }
         break;
@@ -448,15 +1698,51 @@ bool supplemental_page_table_copy(struct supplemental_page_table *dst UNUSED,
                            parent_page->writable)) {
           goto err;
         }
-        if (!vm_claim_page(parent_page->va)) goto err;
+        /* ------- before copy-on-write -------
+        if (!vm_claim_page(parent_page->va)) goto err; */
 
         child_page = spt_find_page(dst, parent_page->va);
         if (!child_page) goto err;
 
-        memcpy(child_page->frame->kva, parent_page->frame->kva, PGSIZE);
+        /* ------- before copy-on-write -------
+        memcpy(child_page->frame->kva, parent_page->frame->kva, PGSIZE); */
+
+        /* 새 frame을 받지 않고 부모의 frame(또는 swap slot)을 공유한다. */
+        anon_initializer(child_page, VM_ANON, NULL);
+        vm_share_page(child_page, parent_page);
+
+        break;
 
+      case VM_FILE:
+        /* added for shared text : 읽기 전용 file page는 복사하지 않는다.
+           child가 접근하면 area에서 page를 만들고 text_cache의 frame을
+           매핑한다. */
+        if (area == NULL || !area->mmap) break;
+
+        /* added for mmap : mmap page는 아직 file에 쓰지 않은 내용이 있을 수
+           있으므로 file에서 다시 읽지 않고 부모의 frame을 공유한다.
+           먼저 쓰는 쪽이 vm_handle_wp()에서 자신만의 frame을 받는다. */
+        {
+          struct file_segment_info aux = {
+              .file = parent_page->file.file,
+              .offset = parent_page->file.offset,
+              .read_bytes = parent_page->file.read_bytes,
+              .zero_bytes = parent_page->file.zero_bytes,
+          };
+
+          if (!vm_alloc_page_with_initializer(VM_FILE, parent_page->va,
+                                              parent_page->writable, NULL,
+                                              &aux))
+            goto err;
+
+          child_page = spt_find_page(dst, parent_page->va);
+          if (!child_page) goto err;
+
+          /* file_backed_initializer()는 aux의 file을 duplicate한다. */
+          if (!file_backed_initializer(child_page, VM_FILE, NULL)) goto err;
+          vm_share_page(child_page, parent_page);
+        }
         break;
-        /* TODO : copy-on-write 구현한다면 부모의 kva를 자식의 va가 가르키도록 설정 */
     }
   }
 
@@ -471,6 +1757,7 @@ static void supplemental_page_destroy(struct hash_elem *e, void *aux UNUSED) {
   struct page *page = hash_entry(e, struct page, spt_elem);
 
   vm_dealloc_page(page);
+  page_cnt--; /* added for VMA */
 }
 
 /**
@@ -487,6 +1774,32 @@ void supplemental_page_table_kill(struct supplemental_page_table *spt UNUSED) {
   // destroy와 clear의 차이는 단지 buchets를 free하는지의 차이인데 안되는 이유를 찾아보라.
   // hash_destroy(&spt->page_table, supplemental_page_destroy);
   hash_clear(&spt->page_table, supplemental_page_destroy);
+
+  /* added for VMA */
+  while (!rb_empty(&spt->areas))
+    area_free(rb_entry(rb_pop_min(&spt->areas), struct vm_area, area_elem));
+}
+
+/* Prints frame table and swap statistics. */
+void vm_print_stats(void) {
+  if (page_cachep == NULL) return; /* vm_init() 전에 종료한 경우 */
+
+  printf("VM: %zu user frames in use (peak %zu), %lld pages evicted, "
+         "%lld pages copied on write\n",
+         frame_cnt, frame_peak, evict_cnt, cow_cnt);
+  printf("VM: %lld text pages mapped from the text cache\n", text_hit_cnt);
+  printf("VM: %lld read faults mapped the zero page, %lld of them later "
+         "written\n",
+         zero_map_cnt, zero_break_cnt);
+  printf("VM: %lld page faults, %lld pages faulted around (window %u)\n",
+         fault_cnt, fault_around_cnt, vm_fault_around);
+  printf("VM: %lld pages prefetched and %lld pages released by madvise\n",
+         prefetch_cnt, release_cnt);
+  printf("VM: at most %lld pages (%zu bytes each) and %lld areas "
+         "(%zu bytes each) alive\n",
+         page_peak, sizeof(struct page), area_peak, sizeof(struct vm_area));
+  swap_print_stats();
+  file_print_stats(); /* added for mmap */
 }
 
 /**